@@ -27,6 +27,7 @@ class Application:
             self.asteroids.append(asteroid)
 
         self.bullets = []
+        self.bullet_mesh = None
 
         self.actions = {
             wutu.events.KEY_LEFT: lambda: self.ship.rotate(-5),
@@ -81,6 +82,19 @@ class Application:
         self.ship.update(dt)
 
 
+    def draw_bullets(self, context):
+        if not self.bullets:
+            return
+        if self.bullet_mesh is None:
+            self.bullet_mesh = context.create_mesh(self.bullets[0].mesh)
+        color = wutu.graphics.color_to_float_values(self.bullets[0].color)
+        transforms = []
+        for bullet in self.bullets:
+            transforms.extend(bullet.position.values)
+            transforms.extend((bullet.angle, 1.0))
+            transforms.extend(color)
+        context.draw_instances(self.bullet_mesh, transforms, wutu.graphics.LINE_LOOP)
+
     def handle_user_input(self):
         for event in wutu.events.poll():
             if event.type == wutu.events.QUIT_EVENT:
@@ -96,8 +110,7 @@ class Application:
         self.ship.draw(context)
         for asteroid in self.asteroids:
             asteroid.draw(context)
-        for bullet in self.bullets:
-            bullet.draw(context)
+        self.draw_bullets(context)
         self.scores.draw(context)
         self.window.update()
 
@@ -109,18 +122,20 @@ class Shape:
         self.velocity = velocity
         self.angle = 0
         self.mesh = self.generate_mesh()
+        self.buffer = None
         self.color = color
 
     def generate_mesh(self):
         return []
 
     def draw(self, context):
+        if self.buffer is None:
+            self.buffer = context.create_mesh(self.mesh)
         context.save()
         context.translate(self.position.values)
         context.rotate(self.angle)
         context.set_color(self.color)
-        context.draw_line_loop(self.mesh, smooth=True)
-        context.draw_line_loop(self.mesh)
+        context.draw_mesh(self.buffer, wutu.graphics.LINE_LOOP, smooth=True)
         context.restore()
 
 
@@ -222,6 +237,7 @@ class Label:
         self._data = None
         self.texture = 0
         self.image = None
+        self.changed = False
         self.template = template
 
     @property
@@ -241,12 +257,15 @@ class Label:
     def text(self, value):
         if value != self._text:
             self.image = self.font.render_text(value)
-            self.texture = 0
+            self.changed = True
         self._text = value
 
     def draw(self, context):
         if not self.texture:
             self.texture = context.create_texture(self.image)
+        elif self.changed:
+            context.update_texture(self.texture, self.image)
+        self.changed = False
         context.save()
         context.translate(*self.position.values)
         context.set_color('#78ba00')
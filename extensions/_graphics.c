@@ -14,6 +14,11 @@
 
 #include "window.h"
 #include "renderer.h"
+#include "offscreen.h"
+#include "mesh.h"
+#include "atlas.h"
+#include "texture.h"
+#include "commandlist.h"
 #include "font.h"
 
 static PyObject*
@@ -89,8 +94,11 @@ PyInit__graphics(void)
     PyObject* module;
 
     if (SDL_Init(SDL_INIT_EVERYTHING) != 0) {
-        PyErr_SetString(PyExc_RuntimeError, SDL_GetError());
-        return NULL;
+        // without a display, offscreen renderers still work
+        if (! Offscreen_IsSupported() || SDL_Init(SDL_INIT_EVERYTHING & ~SDL_INIT_VIDEO) != 0) {
+            PyErr_SetString(PyExc_RuntimeError, SDL_GetError());
+            return NULL;
+        }
     }
 
     if (Font_Init() != 0) {
@@ -110,6 +118,26 @@ PyInit__graphics(void)
         return NULL;
     }
 
+    if (PyType_Ready(&OffscreenRendererType) < 0) {
+        return NULL;
+    }
+
+    if (PyType_Ready(&MeshType) < 0) {
+        return NULL;
+    }
+
+    if (PyType_Ready(&AtlasType) < 0) {
+        return NULL;
+    }
+
+    if (PyType_Ready(&TextureType) < 0) {
+        return NULL;
+    }
+
+    if (PyType_Ready(&CommandListType) < 0) {
+        return NULL;
+    }
+
     module = PyModule_Create(&_graphics_module);
     if (module == NULL) {
         return NULL;
@@ -124,5 +152,20 @@ PyInit__graphics(void)
     Py_INCREF(&RendererType);
     PyModule_AddObject(module, "Renderer", (PyObject *)&RendererType);
 
+    Py_INCREF(&OffscreenRendererType);
+    PyModule_AddObject(module, "OffscreenRenderer", (PyObject *)&OffscreenRendererType);
+
+    Py_INCREF(&MeshType);
+    PyModule_AddObject(module, "Mesh", (PyObject *)&MeshType);
+
+    Py_INCREF(&AtlasType);
+    PyModule_AddObject(module, "Atlas", (PyObject *)&AtlasType);
+
+    Py_INCREF(&TextureType);
+    PyModule_AddObject(module, "Texture", (PyObject *)&TextureType);
+
+    Py_INCREF(&CommandListType);
+    PyModule_AddObject(module, "CommandList", (PyObject *)&CommandListType);
+
     return module;
 }
@@ -0,0 +1,365 @@
+#include "atlas.h"
+
+static int
+AtlasPage_Init(AtlasPage* page, GLState* gl, int width, int height) {
+    unsigned char* blank;
+    page->nodes = (AtlasNode*)malloc(16 * sizeof(AtlasNode));
+    if (page->nodes == NULL) {
+        return -1;
+    }
+    page->capacity = 16;
+    page->length = 1;
+    page->nodes[0].x = 0;
+    page->nodes[0].y = 0;
+    page->nodes[0].width = width;
+    // start transparent, so padding never samples garbage
+    blank = (unsigned char*)calloc((size_t)width * height, 4);
+    if (blank == NULL) {
+        free(page->nodes);
+        return -1;
+    }
+    glGenTextures(1, &page->texture);
+    GLState_BindTexture(gl, page->texture);
+    glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, blank);
+    free(blank);
+    return 0;
+}
+
+// Returns the row a rectangle starting at node index would rest on, or -1.
+static int
+AtlasPage_Fit(AtlasPage* page, int index, int width, int height, int atlas_width, int atlas_height) {
+    int x = page->nodes[index].x;
+    int y = page->nodes[index].y;
+    int remaining = width;
+    if (x + width > atlas_width) {
+        return -1;
+    }
+    while (remaining > 0) {
+        if (index == page->length) {
+            return -1;
+        }
+        if (page->nodes[index].y > y) {
+            y = page->nodes[index].y;
+        }
+        if (y + height > atlas_height) {
+            return -1;
+        }
+        remaining -= page->nodes[index].width;
+        index++;
+    }
+    return y;
+}
+
+static int
+AtlasPage_Insert(AtlasPage* page, int index, int x, int y, int width) {
+    if (page->length == page->capacity) {
+        AtlasNode* nodes = (AtlasNode*)realloc(page->nodes, page->capacity * 2 * sizeof(AtlasNode));
+        if (nodes == NULL) {
+            return -1;
+        }
+        page->nodes = nodes;
+        page->capacity *= 2;
+    }
+    memmove(page->nodes + index + 1, page->nodes + index, (page->length - index) * sizeof(AtlasNode));
+    page->nodes[index].x = x;
+    page->nodes[index].y = y;
+    page->nodes[index].width = width;
+    page->length++;
+    return 0;
+}
+
+static void
+AtlasPage_Remove(AtlasPage* page, int index) {
+    memmove(page->nodes + index, page->nodes + index + 1, (page->length - index - 1) * sizeof(AtlasNode));
+    page->length--;
+}
+
+// Bottom-left skyline packing: picks the position that keeps the skyline lowest.
+static int
+AtlasPage_Pack(AtlasPage* page, int width, int height, int atlas_width, int atlas_height, int* px, int* py) {
+    int best = -1, best_x = -1, best_y = -1, best_top = atlas_height + 1, best_width = atlas_width + 1;
+    for (int i = 0; i < page->length; i++) {
+        int y = AtlasPage_Fit(page, i, width, height, atlas_width, atlas_height);
+        if (y < 0) {
+            continue;
+        }
+        if (y + height < best_top || (y + height == best_top && page->nodes[i].width < best_width)) {
+            best = i;
+            best_top = y + height;
+            best_width = page->nodes[i].width;
+            best_x = page->nodes[i].x;
+            best_y = y;
+        }
+    }
+    if (best < 0) {
+        return 0;
+    }
+    if (AtlasPage_Insert(page, best, best_x, best_y + height, width) != 0) {
+        return -1;
+    }
+    // cut the segments now covered by the new one
+    for (int i = best + 1; i < page->length; i++) {
+        AtlasNode* previous = &page->nodes[i - 1];
+        AtlasNode* node = &page->nodes[i];
+        int shrink = previous->x + previous->width - node->x;
+        if (shrink <= 0) {
+            break;
+        }
+        node->x += shrink;
+        node->width -= shrink;
+        if (node->width > 0) {
+            break;
+        }
+        AtlasPage_Remove(page, i);
+        i--;
+    }
+    for (int i = 0; i + 1 < page->length; i++) {
+        if (page->nodes[i].y == page->nodes[i + 1].y) {
+            page->nodes[i].width += page->nodes[i + 1].width;
+            AtlasPage_Remove(page, i + 1);
+            i--;
+        }
+    }
+    *px = best_x;
+    *py = best_y;
+    return 1;
+}
+
+// Grey or grey + alpha pixels as RGBA.
+static unsigned char*
+Atlas_ExpandLuminance(const unsigned char* pixels, int count, int components) {
+    unsigned char* rgba = (unsigned char*)malloc((size_t)(count ? count : 1) * 4);
+    if (rgba == NULL) {
+        return NULL;
+    }
+    for (int i = 0; i < count; i++) {
+        rgba[i * 4] = rgba[i * 4 + 1] = rgba[i * 4 + 2] = pixels[i * components];
+        rgba[i * 4 + 3] = components == 2 ? pixels[i * 2 + 1] : 255;
+    }
+    return rgba;
+}
+
+static int
+Atlas_init(Atlas* self, PyObject* args, PyObject* kwargs) {
+    PyObject* renderer;
+    GLint max_size = 0;
+    self->padding = 1;
+    if (! PyArg_ParseTuple(args, "O!ii|i", &RendererType, &renderer, &self->width, &self->height, &self->padding)) {
+        return -1;
+    }
+    if (Renderer_MakeCurrent((Renderer*)renderer) != 0) {
+        return -1;
+    }
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &max_size);
+    if (self->width <= 0 || self->height <= 0 || self->width > max_size || self->height > max_size) {
+        PyErr_Format(PyExc_ValueError, "atlas size must be between 1 and %d pixels", max_size);
+        return -1;
+    }
+    if (self->padding < 0) {
+        PyErr_SetString(PyExc_ValueError, "atlas padding must not be negative");
+        return -1;
+    }
+    Py_XDECREF(self->renderer);
+    self->renderer = (Renderer*)renderer;
+    Py_INCREF(self->renderer);
+    return 0;
+}
+
+static void
+Atlas_dealloc(Atlas* self) {
+    // pages only exist once the atlas has a renderer
+    for (int i = 0; i < self->page_count; i++) {
+        Renderer_DeleteTexture(self->renderer, self->pages[i].texture);
+        free(self->pages[i].nodes);
+    }
+    free(self->pages);
+    Py_XDECREF(self->renderer);
+    Py_TYPE(self)->tp_free((PyObject*)self);
+}
+
+int
+Atlas_Add(Atlas* self, const unsigned char* pixels, int width, int height, int components, GLuint* texture, int* px, int* py) {
+    AtlasPage* page = NULL;
+    unsigned char* expanded = NULL;
+    GLenum format;
+    int padded_width, padded_height, x = 0, y = 0, packed = 0;
+    if (width > self->width || height > self->height) {
+        PyErr_SetString(PyExc_ValueError, "image is larger than the atlas");
+        return -1;
+    }
+    // the pages and the state cache both belong to the renderer's context
+    if (Renderer_MakeCurrent(self->renderer) != 0) {
+        return -1;
+    }
+    // padding is only needed between regions, not past the texture edge
+    padded_width = SDL_min(width + self->padding, self->width);
+    padded_height = SDL_min(height + self->padding, self->height);
+    for (int i = 0; i < self->page_count && ! packed; i++) {
+        page = &self->pages[i];
+        packed = AtlasPage_Pack(page, padded_width, padded_height, self->width, self->height, &x, &y);
+    }
+    if (! packed) {
+        AtlasPage* pages = (AtlasPage*)realloc(self->pages, (self->page_count + 1) * sizeof(AtlasPage));
+        if (pages == NULL) {
+            PyErr_NoMemory();
+            return -1;
+        }
+        self->pages = pages;
+        page = &self->pages[self->page_count];
+        if (AtlasPage_Init(page, &self->renderer->gl, self->width, self->height) != 0) {
+            PyErr_NoMemory();
+            return -1;
+        }
+        self->page_count++;
+        packed = AtlasPage_Pack(page, padded_width, padded_height, self->width, self->height, &x, &y);
+    }
+    if (packed < 0) {
+        PyErr_NoMemory();
+        return -1;
+    }
+
+    format = components == 3 ? GL_RGB : GL_RGBA;
+    if (components < 3) {
+        // core profiles have no luminance formats
+        expanded = Atlas_ExpandLuminance(pixels, width * height, components);
+        if (expanded == NULL) {
+            PyErr_NoMemory();
+            return -1;
+        }
+        pixels = expanded;
+    }
+    // the batch binds its own texture on flush
+    GLState_BindTexture(&self->renderer->gl, page->texture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, width, height, format, GL_UNSIGNED_BYTE, pixels);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    free(expanded);
+    *texture = page->texture;
+    *px = x;
+    *py = y;
+    return 0;
+}
+
+int
+Atlas_HasPage(Atlas* self, GLuint texture) {
+    for (int i = 0; i < self->page_count; i++) {
+        if (self->pages[i].texture == texture) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static PyObject*
+Atlas__add(Atlas* self, PyObject* args) {
+    Py_buffer data;
+    GLuint texture;
+    int width, height, components, x, y, result;
+    if (! PyArg_ParseTuple(args, "y*iii", &data, &width, &height, &components)) {
+        return NULL;
+    }
+    if (components < 1 || components > 4 || data.len < (Py_ssize_t)width * height * components) {
+        PyBuffer_Release(&data);
+        PyErr_SetString(PyExc_ValueError, "image pixels don't match its size");
+        return NULL;
+    }
+    result = Atlas_Add(self, (const unsigned char*)data.buf, width, height, components, &texture, &x, &y);
+    PyBuffer_Release(&data);
+    if (result != 0) {
+        return NULL;
+    }
+    return Py_BuildValue("Iiiii", texture, x, y, width, height);
+}
+
+static PyObject*
+Atlas_get_pages(Atlas* self, void* closure) {
+    return PyLong_FromLong(self->page_count);
+}
+
+static PyObject*
+Atlas_get_width(Atlas* self, void* closure) {
+    return PyLong_FromLong(self->width);
+}
+
+static PyObject*
+Atlas_get_height(Atlas* self, void* closure) {
+    return PyLong_FromLong(self->height);
+}
+
+static PyGetSetDef Atlas_getsetters[] = {
+    {
+        "pages",
+        (getter)Atlas_get_pages,
+        NULL,
+        "Number of textures allocated by the atlas.",
+        NULL
+    },
+    {
+        "width",
+        (getter)Atlas_get_width,
+        NULL,
+        "Width of every atlas texture, in pixels.",
+        NULL
+    },
+    {
+        "height",
+        (getter)Atlas_get_height,
+        NULL,
+        "Height of every atlas texture, in pixels.",
+        NULL
+    },
+    {NULL}
+};
+
+static PyMethodDef Atlas_methods[] = {
+    {
+        "_add",
+        (PyCFunction)Atlas__add,
+        METH_VARARGS,
+        "..."
+    },
+    {NULL}
+};
+
+PyTypeObject AtlasType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "wutu._graphics.Atlas",
+    sizeof(Atlas),
+    0,                         /* tp_itemsize */
+    (destructor)Atlas_dealloc,
+    0,                         /* tp_print */
+    0,                         /* tp_getattr */
+    0,                         /* tp_setattr */
+    0,                         /* tp_reserved */
+    0,                         /* tp_repr */
+    0,                         /* tp_as_number */
+    0,                         /* tp_as_sequence */
+    0,                         /* tp_as_mapping */
+    0,                         /* tp_hash  */
+    0,                         /* tp_call */
+    0,                         /* tp_str */
+    0,                         /* tp_getattro */
+    0,                         /* tp_setattro */
+    0,                         /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE,
+    "Packs many images into a few large textures of a rendering context.",
+    0,                         /* tp_traverse */
+    0,                         /* tp_clear */
+    0,                         /* tp_richcompare */
+    0,                         /* tp_weaklistoffset */
+    0,                         /* tp_iter */
+    0,                         /* tp_iternext */
+    Atlas_methods,
+    0,                         /* tp_members */
+    Atlas_getsetters,
+    0,
+    0,                         /* tp_dict */
+    0,                         /* tp_descr_get */
+    0,                         /* tp_descr_set */
+    0,                         /* tp_dictoffset */
+    (initproc)Atlas_init,
+    0,                         /* tp_alloc */
+    (newfunc)PyType_GenericNew
+};
@@ -0,0 +1,49 @@
+#ifndef ATLAS_H
+#define ATLAS_H
+
+#include <Python.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_opengl.h>
+
+#include "renderer.h"
+
+// One horizontal segment of the skyline: the lowest free row above [x, x + width).
+typedef struct {
+    int x;
+    int y;
+    int width;
+} AtlasNode;
+
+typedef struct {
+    GLuint texture;
+    AtlasNode* nodes;
+    int length;
+    int capacity;
+} AtlasPage;
+
+typedef struct {
+    PyObject_HEAD
+    Renderer* renderer;
+    int width;
+    int height;
+    int padding;
+    AtlasPage* pages;
+    int page_count;
+} Atlas;
+
+extern PyTypeObject AtlasType;
+
+// Packs and uploads an image of 1 to 4 components, returning where it went.
+int
+Atlas_Add(Atlas* self, const unsigned char* pixels, int width, int height, int components, GLuint* texture, int* x, int* y);
+
+// Whether texture is one of the pages of the atlas.
+int
+Atlas_HasPage(Atlas* self, GLuint texture);
+
+#endif /* ATLAS_H */
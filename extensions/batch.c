@@ -0,0 +1,134 @@
+#include <stddef.h>
+
+#include "batch.h"
+#include "opengl.h"
+
+void
+Batch_Init(Batch* batch, GLState* gl) {
+    batch->vertices = NULL;
+    batch->length = 0;
+    batch->capacity = 0;
+    batch->state.mode = GL_TRIANGLES;
+    batch->state.texture = 0;
+    batch->state.blend = BATCH_BLEND_ALPHA;
+    batch->state.line_width = 1.0f;
+    batch->state.smooth = 0;
+    batch->draw_calls = 0;
+    batch->gl = gl;
+    batch->buffer = 0;
+    batch->vertex_array = 0;
+    batch->blank_texture = 0;
+}
+
+int
+Batch_InitBuffers(Batch* batch) {
+    static const GLubyte white[4] = {255, 255, 255, 255};
+    if (! OpenGL_HasVertexArrays) {
+        return -1;
+    }
+    glGenTextures(1, &batch->blank_texture);
+    glBindTexture(GL_TEXTURE_2D, batch->blank_texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, white);
+    glGenBuffers(1, &batch->buffer);
+    glGenVertexArrays(1, &batch->vertex_array);
+    glBindVertexArray(batch->vertex_array);
+    glBindBuffer(GL_ARRAY_BUFFER, batch->buffer);
+    glEnableVertexAttribArray(BATCH_ATTRIBUTE_POSITION);
+    glVertexAttribPointer(BATCH_ATTRIBUTE_POSITION, 2, GL_FLOAT, GL_FALSE, sizeof(BatchVertex), (const GLvoid*)offsetof(BatchVertex, x));
+    glEnableVertexAttribArray(BATCH_ATTRIBUTE_TEXTURE_COORDINATE);
+    glVertexAttribPointer(BATCH_ATTRIBUTE_TEXTURE_COORDINATE, 2, GL_FLOAT, GL_FALSE, sizeof(BatchVertex), (const GLvoid*)offsetof(BatchVertex, u));
+    glEnableVertexAttribArray(BATCH_ATTRIBUTE_COLOR);
+    glVertexAttribPointer(BATCH_ATTRIBUTE_COLOR, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(BatchVertex), (const GLvoid*)offsetof(BatchVertex, r));
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    return 0;
+}
+
+void
+Batch_Free(Batch* batch) {
+    free(batch->vertices);
+    if (batch->vertex_array != 0) {
+        glDeleteVertexArrays(1, &batch->vertex_array);
+        glDeleteBuffers(1, &batch->buffer);
+        glDeleteTextures(1, &batch->blank_texture);
+        batch->vertex_array = 0;
+        batch->buffer = 0;
+        batch->blank_texture = 0;
+    }
+    batch->vertices = NULL;
+    batch->length = 0;
+    batch->capacity = 0;
+}
+
+static int
+Batch_StateEqual(const BatchState* a, const BatchState* b) {
+    return a->mode == b->mode
+        && a->texture == b->texture
+        && a->blend == b->blend
+        && a->line_width == b->line_width
+        && a->smooth == b->smooth;
+}
+
+BatchVertex*
+Batch_Append(Batch* batch, const BatchState* state, int count) {
+    BatchVertex* vertices;
+    int capacity;
+    if (! Batch_StateEqual(&batch->state, state)) {
+        Batch_Flush(batch);
+        batch->state = *state;
+    }
+    if (batch->length + count > batch->capacity) {
+        capacity = batch->capacity ? batch->capacity : BATCH_INITIAL_CAPACITY;
+        while (capacity < batch->length + count) {
+            capacity *= 2;
+        }
+        vertices = (BatchVertex*)realloc(batch->vertices, capacity * sizeof(BatchVertex));
+        if (vertices == NULL) {
+            return NULL;
+        }
+        batch->vertices = vertices;
+        batch->capacity = capacity;
+    }
+    vertices = batch->vertices + batch->length;
+    batch->length += count;
+    return vertices;
+}
+
+void
+Batch_Flush(Batch* batch) {
+    BatchState* state = &batch->state;
+    GLState* gl = batch->gl;
+    if (batch->length == 0) {
+        return;
+    }
+    GLState_Blend(gl, state->blend);
+    if (state->mode == GL_LINES) {
+        GLState_LineWidth(gl, state->line_width);
+        GLState_LineSmooth(gl, state->smooth);
+    }
+    if (batch->vertex_array != 0) {
+        GLState_BindTexture(gl, state->texture ? state->texture : batch->blank_texture);
+        glBindVertexArray(batch->vertex_array);
+        glBindBuffer(GL_ARRAY_BUFFER, batch->buffer);
+        // a fresh store each time, so the driver never waits for the last draw
+        glBufferData(GL_ARRAY_BUFFER, batch->length * sizeof(BatchVertex), batch->vertices, GL_STREAM_DRAW);
+        glDrawArrays(state->mode, 0, batch->length);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        glBindVertexArray(0);
+        batch->draw_calls++;
+        batch->length = 0;
+        return;
+    }
+    GLState_BindTexture(gl, state->texture);
+    GLState_ClientArrays(gl, GLSTATE_VERTEX_ARRAY | GLSTATE_COLOR_ARRAY | (state->texture ? GLSTATE_TEXTURE_COORD_ARRAY : 0));
+    glVertexPointer(2, GL_FLOAT, sizeof(BatchVertex), &batch->vertices->x);
+    glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(BatchVertex), &batch->vertices->r);
+    if (state->texture) {
+        glTexCoordPointer(2, GL_FLOAT, sizeof(BatchVertex), &batch->vertices->u);
+    }
+    glDrawArrays(state->mode, 0, batch->length);
+    batch->draw_calls++;
+    batch->length = 0;
+}
@@ -0,0 +1,69 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_opengl.h>
+
+#include "glstate.h"
+
+#define BATCH_BLEND_NONE     0
+#define BATCH_BLEND_ALPHA    1
+#define BATCH_BLEND_ADDITIVE 2
+
+#define BATCH_INITIAL_CAPACITY 1024
+
+// Vertex attribute locations used by shader programs drawing batches.
+#define BATCH_ATTRIBUTE_POSITION           0
+#define BATCH_ATTRIBUTE_TEXTURE_COORDINATE 1
+#define BATCH_ATTRIBUTE_COLOR              2
+
+typedef struct {
+    GLfloat x, y;
+    GLfloat u, v;
+    GLubyte r, g, b, a;
+} BatchVertex;
+
+// Everything that forces a flush when it changes between two draws.
+typedef struct {
+    GLenum mode;
+    GLuint texture;
+    int blend;
+    GLfloat line_width;
+    int smooth;
+} BatchState;
+
+typedef struct {
+    BatchVertex* vertices;
+    int length;
+    int capacity;
+    BatchState state;
+    unsigned long draw_calls;
+    // state of the context the batch draws in
+    GLState* gl;
+    // core profile contexts have no client arrays, so vertices are streamed
+    // through a buffer object instead, untextured draws sample a white texel
+    GLuint buffer;
+    GLuint vertex_array;
+    GLuint blank_texture;
+} Batch;
+
+void
+Batch_Init(Batch* batch, GLState* gl);
+
+int
+Batch_InitBuffers(Batch* batch);
+
+void
+Batch_Free(Batch* batch);
+
+BatchVertex*
+Batch_Append(Batch* batch, const BatchState* state, int count);
+
+void
+Batch_Flush(Batch* batch);
+
+#endif /* BATCH_H */
@@ -0,0 +1,137 @@
+#include <string.h>
+
+#include "capture.h"
+#include "opengl.h"
+
+#define CAPTURE_COMPONENTS 3
+
+void
+Capture_Init(Capture* capture) {
+    memset(capture, 0, sizeof(Capture));
+}
+
+static void
+CaptureSlot_Release(CaptureSlot* slot) {
+    if (slot->fence != NULL) {
+        glDeleteSync(slot->fence);
+        slot->fence = NULL;
+    }
+}
+
+void
+Capture_Free(Capture* capture) {
+    for (int i = 0; i < CAPTURE_SLOTS; i++) {
+        CaptureSlot* slot = &capture->slots[i];
+        CaptureSlot_Release(slot);
+        if (slot->buffer != 0) {
+            glDeleteBuffers(1, &slot->buffer);
+        }
+        free(slot->pixels);
+    }
+    Capture_Init(capture);
+}
+
+void
+Capture_FlipRows(GLubyte* target, const GLubyte* source, int width, int height) {
+    size_t row_size = (size_t)width * CAPTURE_COMPONENTS;
+    for (int y = 0; y < height; y++) {
+        memcpy(target + y * row_size, source + (size_t)(height - y - 1) * row_size, row_size);
+    }
+}
+
+int
+Capture_Request(Capture* capture, int width, int height) {
+    CaptureSlot* slot;
+    size_t size = (size_t)width * height * CAPTURE_COMPONENTS;
+    if (capture->length == CAPTURE_SLOTS) {
+        CaptureSlot_Release(&capture->slots[capture->oldest]);
+        capture->oldest = (capture->oldest + 1) % CAPTURE_SLOTS;
+        capture->length--;
+    }
+    slot = &capture->slots[(capture->oldest + capture->length) % CAPTURE_SLOTS];
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    if (OpenGL_HasPixelBuffers) {
+        if (slot->buffer == 0) {
+            glGenBuffers(1, &slot->buffer);
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, slot->buffer);
+        if (slot->size != size) {
+            glBufferData(GL_PIXEL_PACK_BUFFER, size, NULL, GL_STREAM_READ);
+            slot->size = size;
+        }
+        glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, (GLvoid*)0);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        if (OpenGL_HasSync) {
+            slot->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        }
+    }
+    else {
+        if (slot->size < size) {
+            GLubyte* pixels = (GLubyte*)realloc(slot->pixels, size);
+            if (pixels == NULL) {
+                glPixelStorei(GL_PACK_ALIGNMENT, 4);
+                return -1;
+            }
+            slot->pixels = pixels;
+            slot->size = size;
+        }
+        glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, slot->pixels);
+    }
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    slot->width = width;
+    slot->height = height;
+    capture->length++;
+    return 0;
+}
+
+static int
+Capture_IsReady(Capture* capture, CaptureSlot* slot) {
+    GLenum status;
+    if (slot->buffer == 0) {
+        return 1;
+    }
+    if (slot->fence == NULL) {
+        // without fences, a frame counts as done once a newer one was requested
+        return capture->length > 1;
+    }
+    status = glClientWaitSync(slot->fence, 0, 0);
+    return status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED;
+}
+
+PyObject*
+Capture_Poll(Capture* capture, int wait) {
+    CaptureSlot* slot;
+    PyObject* pixels;
+    if (capture->length == 0) {
+        Py_RETURN_NONE;
+    }
+    slot = &capture->slots[capture->oldest];
+    if (! wait && ! Capture_IsReady(capture, slot)) {
+        Py_RETURN_NONE;
+    }
+    pixels = PyBytes_FromStringAndSize(NULL, (Py_ssize_t)slot->width * slot->height * CAPTURE_COMPONENTS);
+    if (pixels == NULL) {
+        return NULL;
+    }
+    if (slot->buffer != 0) {
+        const GLubyte* source;
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, slot->buffer);
+        source = (const GLubyte*)glMapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY);
+        if (source == NULL) {
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+            Py_DECREF(pixels);
+            PyErr_SetString(PyExc_RuntimeError, "captured pixels can't be mapped");
+            return NULL;
+        }
+        Capture_FlipRows((GLubyte*)PyBytes_AS_STRING(pixels), source, slot->width, slot->height);
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    }
+    else {
+        Capture_FlipRows((GLubyte*)PyBytes_AS_STRING(pixels), slot->pixels, slot->width, slot->height);
+    }
+    CaptureSlot_Release(slot);
+    capture->oldest = (capture->oldest + 1) % CAPTURE_SLOTS;
+    capture->length--;
+    return Py_BuildValue("Nii", pixels, slot->width, slot->height);
+}
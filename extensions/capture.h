@@ -0,0 +1,54 @@
+#ifndef CAPTURE_H
+#define CAPTURE_H
+
+#include <Python.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_opengl.h>
+
+#define CAPTURE_SLOTS 2
+
+// One requested frame, read into a pixel buffer object so glReadPixels
+// returns right away, or into memory when those are not available.
+typedef struct {
+    GLuint buffer;
+    GLubyte* pixels;
+    size_t size;
+    GLsync fence;
+    int width;
+    int height;
+} CaptureSlot;
+
+// Ring of captures: frames are requested at the newest slot and polled
+// from the oldest one, so the GPU has a frame of time to finish copying.
+typedef struct {
+    CaptureSlot slots[CAPTURE_SLOTS];
+    int oldest;
+    int length;
+} Capture;
+
+void
+Capture_Init(Capture* capture);
+
+void
+Capture_Free(Capture* capture);
+
+// Starts reading the framebuffer; drops the oldest frame when all slots
+// are still waiting to be polled.
+int
+Capture_Request(Capture* capture, int width, int height);
+
+// Returns (pixels, width, height) of the oldest frame with rows top to
+// bottom, or None when it is not ready and wait is false.
+PyObject*
+Capture_Poll(Capture* capture, int wait);
+
+// Copies rows of an upside down RGB image in reverse order.
+void
+Capture_FlipRows(GLubyte* target, const GLubyte* source, int width, int height);
+
+#endif /* CAPTURE_H */
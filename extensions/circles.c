@@ -0,0 +1,54 @@
+#include <math.h>
+#include <stdlib.h>
+
+#include "circles.h"
+
+#define CIRCLES_PI 3.14159265358979323846
+#define CIRCLES_TOLERANCE 0.25f
+
+void
+CircleCache_Init(CircleCache* cache) {
+    for (int i = 0; i <= CIRCLES_MAX_SEGMENTS; i++) {
+        cache->tables[i] = NULL;
+    }
+}
+
+void
+CircleCache_Free(CircleCache* cache) {
+    for (int i = 0; i <= CIRCLES_MAX_SEGMENTS; i++) {
+        free(cache->tables[i]);
+    }
+    CircleCache_Init(cache);
+}
+
+const GLfloat*
+CircleCache_Get(CircleCache* cache, int segments) {
+    GLfloat* table = cache->tables[segments];
+    if (table != NULL) {
+        return table;
+    }
+    table = (GLfloat*)malloc(segments * 2 * sizeof(GLfloat));
+    if (table == NULL) {
+        return NULL;
+    }
+    for (int i = 0; i < segments; i++) {
+        double angle = 2.0 * CIRCLES_PI * i / segments;
+        table[i * 2] = (GLfloat)cos(angle);
+        table[i * 2 + 1] = (GLfloat)sin(angle);
+    }
+    cache->tables[segments] = table;
+    return table;
+}
+
+int
+Circles_Segments(float radius) {
+    int segments;
+    if (radius <= CIRCLES_TOLERANCE * 2.0f) {
+        return 8;
+    }
+    segments = (int)ceil(CIRCLES_PI / acos(1.0 - CIRCLES_TOLERANCE / radius));
+    if (segments < 8) {
+        return 8;
+    }
+    return segments > CIRCLES_MAX_SEGMENTS ? CIRCLES_MAX_SEGMENTS : segments;
+}
@@ -0,0 +1,35 @@
+#ifndef CIRCLES_H
+#define CIRCLES_H
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_opengl.h>
+
+#define CIRCLES_MIN_SEGMENTS 3
+#define CIRCLES_MAX_SEGMENTS 256
+
+// Unit circle points, made once for every segment count drawn.
+typedef struct {
+    GLfloat* tables[CIRCLES_MAX_SEGMENTS + 1];
+} CircleCache;
+
+void
+CircleCache_Init(CircleCache* cache);
+
+void
+CircleCache_Free(CircleCache* cache);
+
+// Returns segments interleaved (cos, sin) points around the unit circle,
+// or NULL when out of memory.
+const GLfloat*
+CircleCache_Get(CircleCache* cache, int segments);
+
+// Segments keeping a circle of the given radius within a quarter pixel of
+// the true one.
+int
+Circles_Segments(float radius);
+
+#endif /* CIRCLES_H */
@@ -0,0 +1,113 @@
+#include "commandlist.h"
+
+static int
+CommandList_init(CommandList* self, PyObject* args, PyObject* kwargs) {
+    if (! PyArg_ParseTuple(args, "")) {
+        return -1;
+    }
+    RenderQueue_Clear(&self->commands);
+    Py_CLEAR(self->renderer);
+    Py_CLEAR(self->textures);
+    return 0;
+}
+
+static void
+CommandList_dealloc(CommandList* self) {
+    RenderQueue_Free(&self->commands);
+    Py_XDECREF(self->renderer);
+    Py_XDECREF(self->textures);
+    Py_TYPE(self)->tp_free((PyObject*)self);
+}
+
+int
+CommandList_Begin(CommandList* self, PyObject* renderer) {
+    PyObject* textures = PySet_New(NULL);
+    if (textures == NULL) {
+        return -1;
+    }
+    RenderQueue_Clear(&self->commands);
+    Py_CLEAR(self->renderer);
+    Py_CLEAR(self->textures);
+    Py_INCREF(renderer);
+    self->renderer = renderer;
+    self->textures = textures;
+    return 0;
+}
+
+int
+CommandList_Keep(CommandList* self, PyObject* owner) {
+    return PySet_Add(self->textures, owner);
+}
+
+static PyObject*
+CommandList_get_commands(CommandList* self, void* closure) {
+    return PyLong_FromLong(self->commands.length);
+}
+
+static PyObject*
+CommandList_get_vertices(CommandList* self, void* closure) {
+    return PyLong_FromLong(self->commands.vertex_length);
+}
+
+static PyGetSetDef CommandList_getsetters[] = {
+    {
+        "commands",
+        (getter)CommandList_get_commands,
+        NULL,
+        "Number of recorded draws, after merging consecutive draws with the same state.",
+        NULL
+    },
+    {
+        "vertices",
+        (getter)CommandList_get_vertices,
+        NULL,
+        "Number of recorded vertices.",
+        NULL
+    },
+    {NULL}
+};
+
+static PyMethodDef CommandList_methods[] = {
+    {NULL}
+};
+
+PyTypeObject CommandListType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "wutu._graphics.CommandList",
+    sizeof(CommandList),
+    0,                         /* tp_itemsize */
+    (destructor)CommandList_dealloc,
+    0,                         /* tp_print */
+    0,                         /* tp_getattr */
+    0,                         /* tp_setattr */
+    0,                         /* tp_reserved */
+    0,                         /* tp_repr */
+    0,                         /* tp_as_number */
+    0,                         /* tp_as_sequence */
+    0,                         /* tp_as_mapping */
+    0,                         /* tp_hash  */
+    0,                         /* tp_call */
+    0,                         /* tp_str */
+    0,                         /* tp_getattro */
+    0,                         /* tp_setattro */
+    0,                         /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE,
+    "Draws recorded by a renderer, replayed without calling back into Python.",
+    0,                         /* tp_traverse */
+    0,                         /* tp_clear */
+    0,                         /* tp_richcompare */
+    0,                         /* tp_weaklistoffset */
+    0,                         /* tp_iter */
+    0,                         /* tp_iternext */
+    CommandList_methods,
+    0,                         /* tp_members */
+    CommandList_getsetters,
+    0,
+    0,                         /* tp_dict */
+    0,                         /* tp_descr_get */
+    0,                         /* tp_descr_set */
+    0,                         /* tp_dictoffset */
+    (initproc)CommandList_init,
+    0,                         /* tp_alloc */
+    (newfunc)PyType_GenericNew
+};
@@ -0,0 +1,37 @@
+#ifndef COMMANDLIST_H
+#define COMMANDLIST_H
+
+#include <Python.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_opengl.h>
+
+#include "queue.h"
+
+// Draws recorded by a renderer, as batch states and vertices in the
+// coordinate system that was current when recording began. Transforms
+// and colors are already applied to the vertices, which refer to their
+// textures by name, so the list keeps what owns them alive.
+typedef struct {
+    PyObject_HEAD
+    RenderQueue commands;
+    PyObject* renderer;
+    PyObject* textures;
+} CommandList;
+
+extern PyTypeObject CommandListType;
+
+// Empties the list for a new recording by renderer.
+int
+CommandList_Begin(CommandList* self, PyObject* renderer);
+
+// Keeps an object owning textures the recorded draws use, a Texture,
+// an Atlas or another CommandList, alive as long as the list.
+int
+CommandList_Keep(CommandList* self, PyObject* owner);
+
+#endif /* COMMANDLIST_H */
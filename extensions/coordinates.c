@@ -0,0 +1,341 @@
+#include "coordinates.h"
+
+static double
+Coordinates_ReadInteger(const char* item, char code, Py_ssize_t size) {
+    int is_signed = code >= 'a' && code <= 'z';
+    switch (size) {
+        case 1: return is_signed ? (double)*(const signed char*)item : (double)*(const unsigned char*)item;
+        case 2: return is_signed ? (double)*(const Sint16*)item : (double)*(const Uint16*)item;
+        case 4: return is_signed ? (double)*(const Sint32*)item : (double)*(const Uint32*)item;
+        case 8: return is_signed ? (double)*(const Sint64*)item : (double)*(const Uint64*)item;
+    }
+    return 0.0;
+}
+
+static GLshort
+Coordinates_ToShort(double value) {
+    value = value < 0.0 ? value - 0.5 : value + 0.5;
+    if (value <= -32768.0) {
+        return -32768;
+    }
+    if (value >= 32767.0) {
+        return 32767;
+    }
+    return (GLshort)value;
+}
+
+static GLushort
+Coordinates_ToUnorm16(double value) {
+    if (value <= 0.0) {
+        return 0;
+    }
+    if (value >= 1.0) {
+        return 65535;
+    }
+    return (GLushort)(value * 65535.0 + 0.5);
+}
+
+static GLint
+Coordinates_ToInt(double value) {
+    if (value != value) {
+        return -1;
+    }
+    if (value <= -2147483648.0) {
+        return (GLint)-2147483647 - 1;
+    }
+    if (value >= 2147483647.0) {
+        return 2147483647;
+    }
+    return (GLint)value;
+}
+
+static void*
+Coordinates_Allocate(Coordinates* coordinates, int format) {
+    size_t size = sizeof(GLfloat);
+    coordinates->type = GL_FLOAT;
+    coordinates->normalized = 0;
+    if (format == COORDINATES_INT16) {
+        size = sizeof(GLshort);
+        coordinates->type = GL_SHORT;
+    }
+    else if (format == COORDINATES_UNORM16) {
+        size = sizeof(GLushort);
+        coordinates->type = GL_UNSIGNED_SHORT;
+        coordinates->normalized = 1;
+    }
+    else if (format == COORDINATES_INT32) {
+        size = sizeof(GLint);
+        coordinates->type = GL_INT;
+    }
+    coordinates->owned = malloc((coordinates->length ? coordinates->length : 1) * size);
+    coordinates->data = coordinates->owned;
+    if (coordinates->owned == NULL) {
+        PyErr_NoMemory();
+    }
+    return coordinates->owned;
+}
+
+static void
+Coordinates_Store(Coordinates* coordinates, Py_ssize_t index, double value) {
+    switch (coordinates->type) {
+        case GL_SHORT:
+            ((GLshort*)coordinates->owned)[index] = Coordinates_ToShort(value);
+            break;
+        case GL_UNSIGNED_SHORT:
+            ((GLushort*)coordinates->owned)[index] = Coordinates_ToUnorm16(value);
+            break;
+        case GL_INT:
+            ((GLint*)coordinates->owned)[index] = Coordinates_ToInt(value);
+            break;
+        default:
+            ((GLfloat*)coordinates->owned)[index] = (GLfloat)value;
+            break;
+    }
+}
+
+// Returns 0 when the buffer is usable, 1 when its format is not supported.
+static int
+Coordinates_FromBuffer(Coordinates* coordinates, int format) {
+    Py_buffer* view = &coordinates->view;
+    const char* format_string = view->format ? view->format : "B";
+    const char* item;
+    char code;
+    // explicit byte orders only describe the items when they are native
+    if (*format_string == '@' || *format_string == '=') {
+        format_string++;
+    }
+#if SDL_BYTEORDER == SDL_LIL_ENDIAN
+    else if (*format_string == '<') {
+        format_string++;
+    }
+#else
+    else if (*format_string == '>' || *format_string == '!') {
+        format_string++;
+    }
+#endif
+    code = format_string[0];
+    if (code == '\0' || format_string[1] != '\0' || view->itemsize <= 0) {
+        return 1;
+    }
+    coordinates->length = view->len / view->itemsize;
+    coordinates->data = view->buf;
+    coordinates->normalized = 0;
+    if (code == 'f' && view->itemsize == sizeof(GLfloat)) {
+        coordinates->type = GL_FLOAT;
+        return 0;
+    }
+    if (code == 'd' && view->itemsize == sizeof(GLdouble)) {
+        coordinates->type = GL_DOUBLE;
+        return 0;
+    }
+    if (code == 'h' && view->itemsize == sizeof(GLshort)) {
+        coordinates->type = GL_SHORT;
+        return 0;
+    }
+    if (code == 'H' && view->itemsize == sizeof(GLushort) && format == COORDINATES_UNORM16) {
+        coordinates->type = GL_UNSIGNED_SHORT;
+        coordinates->normalized = 1;
+        return 0;
+    }
+    if ((code == 'i' || code == 'l') && view->itemsize == sizeof(GLint)) {
+        coordinates->type = GL_INT;
+        return 0;
+    }
+    if (strchr("bBhHiIlLqQnN", code) == NULL) {
+        return 1;
+    }
+    // other integer types are converted once without touching Python objects
+    if (Coordinates_Allocate(coordinates, format) == NULL) {
+        return -1;
+    }
+    item = (const char*)view->buf;
+    for (Py_ssize_t i = 0; i < coordinates->length; i++, item += view->itemsize) {
+        Coordinates_Store(coordinates, i, Coordinates_ReadInteger(item, code, view->itemsize));
+    }
+    return 0;
+}
+
+static int
+Coordinates_FromSequence(PyObject* object, int format, Coordinates* coordinates) {
+    PyObject* sequence;
+    PyObject** items;
+    sequence = PySequence_Fast(object, "coordinates must be a sequence of float values (x0, y0, x1, y1 ...)");
+    if (sequence == NULL) {
+        return -1;
+    }
+    coordinates->length = PySequence_Fast_GET_SIZE(sequence);
+    if (Coordinates_Allocate(coordinates, format) == NULL) {
+        Py_DECREF(sequence);
+        return -1;
+    }
+    items = PySequence_Fast_ITEMS(sequence);
+    for (Py_ssize_t i = 0; i < coordinates->length; i++) {
+        double value = PyFloat_AsDouble(items[i]);
+        if (value == -1.0 && PyErr_Occurred()) {
+            Py_DECREF(sequence);
+            return -1;
+        }
+        Coordinates_Store(coordinates, i, value);
+    }
+    Py_DECREF(sequence);
+    return 0;
+}
+
+int
+Coordinates_FromObject(PyObject* object, int format, Coordinates* coordinates) {
+    int result;
+    memset(coordinates, 0, sizeof(Coordinates));
+    if (PyObject_CheckBuffer(object)) {
+        if (PyObject_GetBuffer(object, &coordinates->view, PyBUF_C_CONTIGUOUS | PyBUF_FORMAT) == 0) {
+            coordinates->has_view = 1;
+            result = Coordinates_FromBuffer(coordinates, format);
+            if (result < 0) {
+                Coordinates_Release(coordinates);
+                return -1;
+            }
+            if (result == 0) {
+                return 0;
+            }
+            PyBuffer_Release(&coordinates->view);
+            coordinates->has_view = 0;
+        }
+        else {
+            // e.g. strided views, which still work through the sequence protocol
+            PyErr_Clear();
+        }
+    }
+    if (Coordinates_FromSequence(object, format, coordinates) != 0) {
+        Coordinates_Release(coordinates);
+        return -1;
+    }
+    return 0;
+}
+
+const GLfloat*
+Coordinates_AsFloats(Coordinates* coordinates) {
+    Py_ssize_t length = coordinates->length;
+    GLfloat* floats;
+    if (coordinates->type == GL_FLOAT) {
+        return (const GLfloat*)coordinates->data;
+    }
+    if (coordinates->floats != NULL) {
+        return coordinates->floats;
+    }
+    floats = (GLfloat*)malloc((length ? length : 1) * sizeof(GLfloat));
+    if (floats == NULL) {
+        PyErr_NoMemory();
+        return NULL;
+    }
+    switch (coordinates->type) {
+        case GL_DOUBLE: {
+            const GLdouble* values = (const GLdouble*)coordinates->data;
+            for (Py_ssize_t i = 0; i < length; i++) {
+                floats[i] = (GLfloat)values[i];
+            }
+            break;
+        }
+        case GL_SHORT: {
+            const GLshort* values = (const GLshort*)coordinates->data;
+            for (Py_ssize_t i = 0; i < length; i++) {
+                floats[i] = (GLfloat)values[i];
+            }
+            break;
+        }
+        case GL_UNSIGNED_SHORT: {
+            const GLushort* values = (const GLushort*)coordinates->data;
+            for (Py_ssize_t i = 0; i < length; i++) {
+                floats[i] = values[i] * (1.0f / 65535.0f);
+            }
+            break;
+        }
+        case GL_INT: {
+            const GLint* values = (const GLint*)coordinates->data;
+            for (Py_ssize_t i = 0; i < length; i++) {
+                floats[i] = (GLfloat)values[i];
+            }
+            break;
+        }
+    }
+    coordinates->floats = floats;
+    return floats;
+}
+
+const GLshort*
+Coordinates_AsShorts(Coordinates* coordinates) {
+    Py_ssize_t length = coordinates->length;
+    const GLfloat* floats;
+    GLshort* shorts;
+    if (coordinates->type == GL_SHORT) {
+        return (const GLshort*)coordinates->data;
+    }
+    if (coordinates->shorts != NULL) {
+        return coordinates->shorts;
+    }
+    shorts = (GLshort*)malloc((length ? length : 1) * sizeof(GLshort));
+    if (shorts == NULL) {
+        PyErr_NoMemory();
+        return NULL;
+    }
+    floats = Coordinates_AsFloats(coordinates);
+    if (floats == NULL) {
+        free(shorts);
+        return NULL;
+    }
+    for (Py_ssize_t i = 0; i < length; i++) {
+        shorts[i] = Coordinates_ToShort(floats[i]);
+    }
+    coordinates->shorts = shorts;
+    return shorts;
+}
+
+const GLint*
+Coordinates_AsInts(Coordinates* coordinates) {
+    Py_ssize_t length = coordinates->length;
+    GLint* ints;
+    if (coordinates->type == GL_INT) {
+        return (const GLint*)coordinates->data;
+    }
+    if (coordinates->ints != NULL) {
+        return coordinates->ints;
+    }
+    ints = (GLint*)malloc((length ? length : 1) * sizeof(GLint));
+    if (ints == NULL) {
+        PyErr_NoMemory();
+        return NULL;
+    }
+    for (Py_ssize_t i = 0; i < length; i++) {
+        switch (coordinates->type) {
+            case GL_DOUBLE:
+                ints[i] = Coordinates_ToInt(((const GLdouble*)coordinates->data)[i]);
+                break;
+            case GL_SHORT:
+                ints[i] = ((const GLshort*)coordinates->data)[i];
+                break;
+            case GL_UNSIGNED_SHORT:
+                ints[i] = ((const GLushort*)coordinates->data)[i];
+                break;
+            default:
+                ints[i] = Coordinates_ToInt(((const GLfloat*)coordinates->data)[i]);
+                break;
+        }
+    }
+    coordinates->ints = ints;
+    return ints;
+}
+
+void
+Coordinates_Release(Coordinates* coordinates) {
+    if (coordinates->has_view) {
+        PyBuffer_Release(&coordinates->view);
+        coordinates->has_view = 0;
+    }
+    free(coordinates->owned);
+    free(coordinates->floats);
+    free(coordinates->shorts);
+    free(coordinates->ints);
+    coordinates->owned = NULL;
+    coordinates->floats = NULL;
+    coordinates->shorts = NULL;
+    coordinates->ints = NULL;
+    coordinates->data = NULL;
+}
@@ -0,0 +1,54 @@
+#ifndef COORDINATES_H
+#define COORDINATES_H
+
+#include <Python.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_opengl.h>
+
+#define COORDINATES_FLOAT32 0
+#define COORDINATES_INT16   1
+#define COORDINATES_UNORM16 2
+// for indices and counts, which must not round through float32
+#define COORDINATES_INT32   3
+
+// Flat (x0, y0, x1, y1 ...) values taken from a Python object.
+// C-contiguous buffers of float, double, short or int are used in place,
+// anything else is converted once into a temporary array of the requested
+// format: float32, int16 rounded to whole pixels, uint16 normalized to
+// [0, 1] for texture coordinates, or int32.
+typedef struct {
+    Py_buffer view;
+    int has_view;
+    void* data;
+    GLenum type;
+    int normalized;
+    Py_ssize_t length;
+    void* owned;
+    GLfloat* floats;
+    GLshort* shorts;
+    GLint* ints;
+} Coordinates;
+
+int
+Coordinates_FromObject(PyObject* object, int format, Coordinates* coordinates);
+
+const GLfloat*
+Coordinates_AsFloats(Coordinates* coordinates);
+
+// Values rounded to whole pixels, for vertex positions.
+const GLshort*
+Coordinates_AsShorts(Coordinates* coordinates);
+
+// Values truncated to integers, out of range ones clamped and NaN as -1.
+const GLint*
+Coordinates_AsInts(Coordinates* coordinates);
+
+void
+Coordinates_Release(Coordinates* coordinates);
+
+#endif /* COORDINATES_H */
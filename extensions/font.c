@@ -1,134 +1,336 @@
 #include "font.h"
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define FONT_SSE2
+#endif
+
 static FT_Error error;
 
 static FT_Library freetype;
 
+// 8 coverage bytes, 0 or 255, for every byte of a 1 bit per pixel bitmap.
+static unsigned char mono_table[256][8];
+
 int
 Font_Init() {
+    for (int c = 0; c < 256; c++) {
+        for (int b = 0; b < 8; b++) {
+            mono_table[c][b] = (c & (0x80 >> b)) ? 255 : 0;
+        }
+    }
     error = FT_Init_FreeType(&freetype);
     return error;
 }
 
-unsigned char*
-unpack_bitmap_mono(FT_Bitmap bitmap) {
-    unsigned char* buffer = (unsigned char*)malloc(bitmap.width * bitmap.rows);
-    unsigned char* dist = buffer;
-    for (int row = 0; row < bitmap.rows; row++)
+void
+unpack_bitmap_mono(FT_Bitmap bitmap, unsigned char* buffer) {
+    int width = bitmap.width;
+    for (int row = 0; row < (int)bitmap.rows; row++)
     {
-        for (int p = 0; p < bitmap.pitch; p++)
+        const unsigned char* bits = bitmap.buffer + row * bitmap.pitch;
+        unsigned char* dist = buffer + row * width;
+        int x = 0;
+        for (; x + 8 <= width; x += 8)
+        {
+            memcpy(dist + x, mono_table[bits[x / 8]], 8);
+        }
+        if (x < width)
         {
-            unsigned char c = bitmap.buffer[p + row * bitmap.pitch];
-            for( int b = 0; b < 8; b++)
-            {
-                if (b + p * 8 < bitmap.width)
-                {
-                    int v = (c&0x80) >> 7;
-                    *(dist++) = (unsigned char)v * 255;
-                    c <<= 1;
-                }
+            memcpy(dist + x, mono_table[bits[x / 8]], width - x);
+        }
+    }
+}
+
+// Fills count RGBA pixels with white and the given coverage as alpha.
+static void
+Font_ExpandCoverage(unsigned char* pixels, const unsigned char* coverage, int count) {
+    int i = 0;
+#ifdef FONT_SSE2
+    __m128i white = _mm_set1_epi32(0x00FFFFFF);
+    __m128i zero = _mm_setzero_si128();
+    // coverage bytes end up in the top byte of every little endian pixel
+    for (; i + 16 <= count; i += 16) {
+        __m128i alpha = _mm_loadu_si128((const __m128i*)(coverage + i));
+        __m128i low = _mm_unpacklo_epi8(zero, alpha);
+        __m128i high = _mm_unpackhi_epi8(zero, alpha);
+        _mm_storeu_si128((__m128i*)(pixels + i * 4), _mm_or_si128(_mm_unpacklo_epi16(zero, low), white));
+        _mm_storeu_si128((__m128i*)(pixels + i * 4 + 16), _mm_or_si128(_mm_unpackhi_epi16(zero, low), white));
+        _mm_storeu_si128((__m128i*)(pixels + i * 4 + 32), _mm_or_si128(_mm_unpacklo_epi16(zero, high), white));
+        _mm_storeu_si128((__m128i*)(pixels + i * 4 + 48), _mm_or_si128(_mm_unpackhi_epi16(zero, high), white));
+    }
+#endif
+    for (; i < count; i++) {
+        pixels[i * 4] = 255;
+        pixels[i * 4 + 1] = 255;
+        pixels[i * 4 + 2] = 255;
+        pixels[i * 4 + 3] = coverage[i];
+    }
+}
+
+// Fills count RGBA pixels with transparent white.
+static void
+Font_ClearWhite(unsigned char* pixels, int count) {
+    int i = 0;
+#ifdef FONT_SSE2
+    __m128i white = _mm_set1_epi32(0x00FFFFFF);
+    for (; i + 4 <= count; i += 4) {
+        _mm_storeu_si128((__m128i*)(pixels + i * 4), white);
+    }
+#endif
+    for (; i < count; i++) {
+        pixels[i * 4] = 255;
+        pixels[i * 4 + 1] = 255;
+        pixels[i * 4 + 2] = 255;
+        pixels[i * 4 + 3] = 0;
+    }
+}
+
+#ifdef FONT_SSE2
+// Keeps the first n bytes of a vector with a load at mask_table + 16 - n.
+static const unsigned char mask_table[32] = {
+    255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255
+};
+#endif
+
+// Raises the last component of count pixels to the given coverage, so
+// overlapping glyphs keep the ink of both. Vectors may run past count
+// while room bytes of pixels are left, as they leave those pixels as is.
+// The SSE2 and scalar paths give the same bytes, but where glyph boxes
+// overlap those differ from the overwritten coverage of older images.
+static void
+Font_MaxCoverage(unsigned char* pixels, const unsigned char* coverage, int count, int components, size_t room) {
+    int i = 0;
+#ifdef FONT_SSE2
+    if (components == 1) {
+        for (; i < count && (size_t)i + 16 <= room; i += 16) {
+            __m128i mask = _mm_loadu_si128((const __m128i*)(mask_table + 16 - SDL_min(count - i, 16)));
+            __m128i alpha = _mm_and_si128(_mm_loadu_si128((const __m128i*)(coverage + i)), mask);
+            __m128i current = _mm_loadu_si128((const __m128i*)(pixels + i));
+            _mm_storeu_si128((__m128i*)(pixels + i), _mm_max_epu8(current, alpha));
+        }
+    }
+    else if (components == 4) {
+        __m128i zero = _mm_setzero_si128();
+        // zero color bytes leave the color unchanged
+        for (; i < count && (size_t)(i + 16) * 4 <= room; i += 16) {
+            __m128i mask = _mm_loadu_si128((const __m128i*)(mask_table + 16 - SDL_min(count - i, 16)));
+            __m128i alpha = _mm_and_si128(_mm_loadu_si128((const __m128i*)(coverage + i)), mask);
+            __m128i low = _mm_unpacklo_epi8(zero, alpha);
+            __m128i high = _mm_unpackhi_epi8(zero, alpha);
+            __m128i* out = (__m128i*)(pixels + i * 4);
+            _mm_storeu_si128(out, _mm_max_epu8(_mm_loadu_si128(out), _mm_unpacklo_epi16(zero, low)));
+            if (count - i > 4) {
+                _mm_storeu_si128(out + 1, _mm_max_epu8(_mm_loadu_si128(out + 1), _mm_unpackhi_epi16(zero, low)));
+            }
+            if (count - i > 8) {
+                _mm_storeu_si128(out + 2, _mm_max_epu8(_mm_loadu_si128(out + 2), _mm_unpacklo_epi16(zero, high)));
+                _mm_storeu_si128(out + 3, _mm_max_epu8(_mm_loadu_si128(out + 3), _mm_unpackhi_epi16(zero, high)));
             }
         }
     }
-    return buffer;
+#endif
+    for (; i < count; i++) {
+        unsigned char* alpha = pixels + i * components + components - 1;
+        *alpha = coverage[i] > *alpha ? coverage[i] : *alpha;
+    }
 }
 
-void
-unsafe_blit_alpha(unsigned char* pixels, int px, int py, int image_width, unsigned char* alpha, int a_w, int a_h) {
-    int components = 4; // RGBA
-    for (int y = 0; y < a_h; y++)
+// Composites glyph coverage into an image, clipped to its bounds.
+static void
+Font_BlitAlpha(unsigned char* pixels, int image_width, int image_height, int components, int px, int py, const FontGlyphPixmap* glyph) {
+    int left = px < 0 ? -px : 0;
+    int top = py < 0 ? -py : 0;
+    int right = px + glyph->width > image_width ? image_width - px : glyph->width;
+    int bottom = py + glyph->height > image_height ? image_height - py : glyph->height;
+    size_t size = (size_t)image_width * image_height * components;
+    if (left >= right) {
+        return;
+    }
+    for (int y = top; y < bottom; y++)
     {
-        unsigned char* cur = pixels + (y + py) * image_width * components;
-        for (int x = 0; x < a_w; x++)
-        {
-            // A index == 3
-            *(cur + 3 + (x + px) * components) = *(alpha + x + y * a_w);
-        }
+        const unsigned char* alpha = glyph->buffer + y * glyph->width + left;
+        size_t offset = ((size_t)(y + py) * image_width + px + left) * components;
+        Font_MaxCoverage(pixels + offset, alpha, right - left, components, size - offset);
     }
 }
 
 FontGlyphPixmap*
 load_pixmap(Font* self, int unicode) {
     FontGlyphPixmap* pixmap;
-    PyObject* capsule;
+    FT_GlyphSlot slot;
 
-    FT_GlyphSlot slot = self->face->glyph;
-
-    PyObject* key = PyLong_FromLong(unicode);
-    capsule = PyDict_GetItem(self->glyph_cache, key);
-    if (capsule != NULL)
+    pixmap = GlyphStore_Get(&self->glyphs, (Uint32)unicode);
+    if (pixmap != NULL)
+    {
+        return pixmap;
+    }
+    error = FT_Load_Char(self->face, unicode, FT_LOAD_RENDER);
+    if (error)
     {
-        return (FontGlyphPixmap*)PyCapsule_GetPointer(capsule, NULL);
+        return NULL;
     }
-    pixmap = (FontGlyphPixmap*)malloc(sizeof(FontGlyphPixmap));
-    if(FT_Load_Char(self->face, unicode, FT_LOAD_RENDER))
+    slot = self->face->glyph;
+    pixmap = GlyphStore_Add(&self->glyphs, (Uint32)unicode, slot->bitmap.width, slot->bitmap.rows);
+    if (pixmap == NULL)
     {
+        error = FT_Err_Out_Of_Memory;
         return NULL;
     }
-    pixmap->width = slot->bitmap.width;
-    pixmap->height = slot->bitmap.rows;
     pixmap->advance_x = (slot->advance.x >> 6);
     pixmap->y_offset = (self->face->size->metrics.ascender >> 6) - slot->bitmap_top;
     pixmap->x_offset = (slot->metrics.horiBearingX >> 6);
 
     if (slot->bitmap.pixel_mode == FT_PIXEL_MODE_MONO)
     {
-        pixmap->buffer = unpack_bitmap_mono(slot->bitmap);
+        unpack_bitmap_mono(slot->bitmap, pixmap->buffer);
     }
     else
     {
-        pixmap->buffer = (unsigned char*)malloc(pixmap->width * pixmap->height);
-        for(int i = 0; i < pixmap->width * pixmap->height; i++)
+        for (int row = 0; row < pixmap->height; row++)
         {
-            pixmap->buffer[i] = slot->bitmap.buffer[i];
+            memcpy(pixmap->buffer + row * pixmap->width, slot->bitmap.buffer + row * slot->bitmap.pitch, pixmap->width);
         }
     }
-    capsule = PyCapsule_New(pixmap, NULL, NULL);
-    PyDict_SetItem(self->glyph_cache, key, capsule);
-    Py_DECREF(key);
     return pixmap;
 }
 
-FT_Error
-Font_text_size(Font* self, PyObject* text, int* width, int* height) {
-    FontGlyphPixmap* pixmap;
-    int unicode;
-    int text_length;
-    int line_width = 0;
-    int lines = 1;
-    text_length = PyUnicode_GetLength(text);
-    *height = 0;
-    *width = 0;
-    for (int index = 0; index < text_length; index++)
-    {
-        unicode = PyUnicode_ReadChar(text, index);
-        if (unicode == UNICODE_BOM_NATIVE || unicode == UNICODE_BOM_SWAPPED)
-        {
-            continue;
-        }
-        if (unicode == UNICODE_NEW_LINE)
-        {
-            lines++;
-            if (line_width > *width)
-            {
-                *width = line_width;
-            }
-            line_width = 0;
-            continue;
+// Atlas placements are only valid for one renderer, so drawing with
+// another one starts a new atlas. The old one deletes its pages through
+// Renderer_DeleteTexture, which first draws what its renderer still has
+// pending, and command lists that recorded glyphs keep it alive.
+static Atlas*
+Font_Atlas(Font* self, Renderer* renderer) {
+    if (self->atlas != NULL && self->atlas->renderer == renderer) {
+        return self->atlas;
+    }
+    Py_CLEAR(self->atlas);
+    for (FontGlyphPixmap* glyph = self->glyphs.first; glyph != NULL; glyph = glyph->next) {
+        glyph->texture = 0;
+    }
+    self->atlas = (Atlas*)PyObject_CallFunction((PyObject*)&AtlasType, "Oii", renderer, FONT_ATLAS_SIZE, FONT_ATLAS_SIZE);
+    return self->atlas;
+}
+
+int
+Font_AtlasGlyph(Font* self, Renderer* renderer, FontGlyphPixmap* glyph) {
+    Atlas* atlas;
+    unsigned char* pixels;
+    int count, result;
+    atlas = Font_Atlas(self, renderer);
+    if (atlas == NULL) {
+        return -1;
+    }
+    if (glyph->texture != 0 || glyph->width == 0 || glyph->height == 0) {
+        return 0;
+    }
+    // white with the glyph coverage as alpha, tinted by the vertex color
+    count = glyph->width * glyph->height;
+    pixels = (unsigned char*)malloc(count * 4);
+    if (pixels == NULL) {
+        PyErr_NoMemory();
+        return -1;
+    }
+    Font_ExpandCoverage(pixels, glyph->buffer, count);
+    result = Atlas_Add(atlas, pixels, glyph->width, glyph->height, 4, &glyph->texture, &glyph->atlas_x, &glyph->atlas_y);
+    free(pixels);
+    if (result != 0) {
+        glyph->texture = 0;
+        return -1;
+    }
+    return 0;
+}
+
+typedef struct {
+    int pen_x;
+    int pen_y;
+    int line_height;
+} FontPen;
+
+static int
+Font_LayoutCharacter(Font* self, FontLayout* layout, FontPen* pen, Py_UCS4 unicode) {
+    FontGlyphPixmap* glyph;
+    FontGlyphPlacement* placement;
+    if (unicode == UNICODE_BOM_NATIVE || unicode == UNICODE_BOM_SWAPPED) {
+        return 0;
+    }
+    if (unicode == UNICODE_NEW_LINE) {
+        if (pen->pen_x > layout->width) {
+            layout->width = pen->pen_x;
         }
-        pixmap = load_pixmap(self, unicode);
-        if (pixmap == NULL)
-        {
+        pen->pen_x = 0;
+        pen->pen_y += pen->line_height;
+        layout->height += pen->line_height;
+        return 0;
+    }
+    glyph = load_pixmap(self, (int)unicode);
+    if (glyph == NULL) {
+        PyErr_SetString(PyExc_RuntimeError, Font_GetError());
+        return -1;
+    }
+    placement = &layout->placements[layout->length++];
+    placement->glyph = glyph;
+    placement->x = pen->pen_x;
+    placement->y = pen->pen_y;
+    pen->pen_x += glyph->advance_x;
+    return 0;
+}
+
+int
+Font_Layout(Font* self, PyObject* text) {
+    FontLayout* layout = &self->layout;
+    FontPen pen;
+    Py_ssize_t length;
+    const void* data;
+    int result = 0;
+    if (self->face == NULL) {
+        PyErr_SetString(PyExc_RuntimeError, "font is not loaded");
+        return -1;
+    }
+    length = PyUnicode_GET_LENGTH(text);
+    if (length > INT_MAX) {
+        PyErr_SetString(PyExc_ValueError, "text is too long");
+        return -1;
+    }
+    // at most one glyph per character
+    if (length > layout->capacity) {
+        FontGlyphPlacement* placements = (FontGlyphPlacement*)realloc(layout->placements, length * sizeof(FontGlyphPlacement));
+        if (placements == NULL) {
+            PyErr_NoMemory();
             return -1;
         }
-        line_width += pixmap->advance_x;
+        layout->placements = placements;
+        layout->capacity = (int)length;
     }
-    if (line_width > *width)
-    {
-        *width = line_width;
+    pen.pen_x = 0;
+    pen.pen_y = 0;
+    pen.line_height = self->face->size->metrics.height >> 6;
+    layout->length = 0;
+    layout->width = 0;
+    layout->height = pen.line_height;
+    data = PyUnicode_DATA(text);
+    // the canonical buffer is read in place, one loop per character width
+    switch (PyUnicode_KIND(text)) {
+        case PyUnicode_1BYTE_KIND:
+            for (Py_ssize_t i = 0; i < length && result == 0; i++) {
+                result = Font_LayoutCharacter(self, layout, &pen, ((const Py_UCS1*)data)[i]);
+            }
+            break;
+        case PyUnicode_2BYTE_KIND:
+            for (Py_ssize_t i = 0; i < length && result == 0; i++) {
+                result = Font_LayoutCharacter(self, layout, &pen, ((const Py_UCS2*)data)[i]);
+            }
+            break;
+        default:
+            for (Py_ssize_t i = 0; i < length && result == 0; i++) {
+                result = Font_LayoutCharacter(self, layout, &pen, ((const Py_UCS4*)data)[i]);
+            }
+            break;
+    }
+    if (pen.pen_x > layout->width) {
+        layout->width = pen.pen_x;
     }
-    *height = lines * (self->face->size->metrics.height >> 6);
-    return FT_Err_Ok;
+    return result;
 }
 
 static PyObject*
@@ -139,6 +341,14 @@ Font_load(Font* self, PyObject* args) {
     {
         return NULL;
     }
+    // glyphs and their atlas belong to the previous face
+    GlyphStore_Free(&self->glyphs);
+    Py_CLEAR(self->atlas);
+    if (self->face != NULL)
+    {
+        FT_Done_Face(self->face);
+        self->face = NULL;
+    }
     error = FT_New_Face(freetype, path, 0, &self->face);
     if (error)
     {
@@ -176,58 +386,68 @@ Font_load(Font* self, PyObject* args) {
 
 static PyObject*
 Font_render_text(Font* self, PyObject* args, PyObject* kwargs) {
+    static char* keywords[] = {"text", "components", "tight", "buffer", NULL};
     PyObject* text;
-    PyObject* attributes;
+    PyObject* buffer = Py_None;
     PyObject* pixels;
-    int text_length, image_width = 1, image_height = 1, image_components = 4;
-    int unicode;
+    PyObject* attributes;
+    Py_buffer view;
+    int image_width = 1, image_height = 1, image_components = 4, tight = 0;
+    Py_ssize_t size;
     unsigned char* data;
-    FT_GlyphSlot slot = self->face->glyph;
-    FontGlyphPixmap* pixmap;
-    if (! PyArg_ParseTuple(args, "O", &text)) {
+    FontLayout* layout = &self->layout;
+    if (! PyArg_ParseTupleAndKeywords(args, kwargs, "U|ipO", keywords, &text, &image_components, &tight, &buffer)) {
+        return NULL;
+    }
+    if (image_components != 1 && image_components != 4) {
+        PyErr_SetString(PyExc_ValueError, "text images have 1 or 4 components");
         return NULL;
     }
-    int text_w = 0, text_h = 0;
-    error = Font_text_size(self, text, &text_w, &text_h);
-    if (error != FT_Err_Ok) {
-        PyErr_SetString(PyExc_RuntimeError, "Font_text_size");
+    if (Font_Layout(self, text) != 0) {
         return NULL;
     }
-    while (image_width < text_w) image_width *= 2;
-    while (image_height < text_h) image_height *= 2;
-    data = (unsigned char*)malloc(image_width * image_height * image_components);
-    for(int i = 0; i < image_width * image_height; i++) {
-        data[i * 4 + 0] = 255;
-        data[i * 4 + 1] = 255;
-        data[i * 4 + 2] = 255;
-        data[i * 4 + 3] = 0;
-    }
-    int pen_x = 0, pen_y = 0;
-    text_length = PyUnicode_GetLength(text);
-    for (int index = 0; index < text_length; index++) {
-        unicode = PyUnicode_ReadChar(text, index);
-        if (unicode == UNICODE_BOM_NATIVE || unicode == UNICODE_BOM_SWAPPED) {
-            continue;
+    if (tight) {
+        image_width = layout->width > 1 ? layout->width : 1;
+        image_height = layout->height > 1 ? layout->height : 1;
+    }
+    else {
+        while (image_width < layout->width) image_width *= 2;
+        while (image_height < layout->height) image_height *= 2;
+    }
+    size = (Py_ssize_t)image_width * image_height * image_components;
+    if (buffer == Py_None) {
+        pixels = PyBytes_FromStringAndSize(NULL, size);
+        if (pixels == NULL) {
+            return NULL;
         }
-        if (unicode == UNICODE_NEW_LINE) {
-            pen_y += (self->face->size->metrics.height >> 6);
-            pen_x = 0;
-            continue;
+        data = (unsigned char*)PyBytes_AS_STRING(pixels);
+    }
+    else {
+        if (PyObject_GetBuffer(buffer, &view, PyBUF_WRITABLE) != 0) {
+            return NULL;
         }
-        pixmap = load_pixmap(self, unicode);
-        if (error) {
-            PyErr_SetString(PyExc_RuntimeError, Font_GetError());
+        if (view.len < size) {
+            PyBuffer_Release(&view);
+            PyErr_Format(PyExc_ValueError, "text needs a buffer of %zd bytes", size);
             return NULL;
         }
-        int y = pen_y + pixmap->y_offset;
-        int x = pen_x + pixmap->x_offset;
-        unsafe_blit_alpha(data, x, y, image_width, pixmap->buffer, pixmap->width, pixmap->height);
-        pen_x += pixmap->advance_x;
+        pixels = buffer;
+        Py_INCREF(pixels);
+        data = (unsigned char*)view.buf;
     }
-    pixels = PyBytes_FromStringAndSize((const char*)data, image_width * image_height * image_components);
-    free(data);
-    if (pixels == NULL) {
-        return NULL;
+    if (image_components == 1) {
+        memset(data, 0, size);
+    }
+    else {
+        Font_ClearWhite(data, image_width * image_height);
+    }
+    for (int i = 0; i < layout->length; i++) {
+        const FontGlyphPlacement* placement = &layout->placements[i];
+        const FontGlyphPixmap* pixmap = placement->glyph;
+        Font_BlitAlpha(data, image_width, image_height, image_components, placement->x + pixmap->x_offset, placement->y + pixmap->y_offset, pixmap);
+    }
+    if (buffer != Py_None) {
+        PyBuffer_Release(&view);
     }
     attributes = Py_BuildValue("Oiii", pixels, image_width, image_height, image_components);
     Py_DECREF(pixels);
@@ -237,26 +457,29 @@ Font_render_text(Font* self, PyObject* args, PyObject* kwargs) {
 static PyObject*
 Font_measure_text(Font* self, PyObject* args) {
     PyObject* text;
-    int width, height;
-    if (! PyArg_ParseTuple(args, "O", &text)) {
+    if (! PyArg_ParseTuple(args, "U", &text)) {
         return NULL;
     }
-    error = Font_text_size(self, text, &width, &height);
-    if (error) {
-        PyErr_SetString(PyExc_RuntimeError, Font_GetError());
+    if (Font_Layout(self, text) != 0) {
         return NULL;
     }
-    return Py_BuildValue("ii", width, height);
+    return Py_BuildValue("ii", self->layout.width, self->layout.height);
 }
 
 static int
 Font_init(Font* self, PyObject* args, PyObject* kwargs) {
-    self->glyph_cache = PyDict_New();
+    GlyphStore_Free(&self->glyphs);
     return 0;
 }
 
 static void
 Font_dealloc(Font* self) {
+    Py_XDECREF(self->atlas);
+    GlyphStore_Free(&self->glyphs);
+    free(self->layout.placements);
+    if (self->face != NULL) {
+        FT_Done_Face(self->face);
+    }
     Py_TYPE(self)->tp_free((PyObject*)self);
 }
 
@@ -7,10 +7,15 @@
 #include FT_FREETYPE_H
 #include FT_TRUETYPE_IDS_H
 
+#include "atlas.h"
+#include "glyphs.h"
+
 #define UNICODE_BOM_NATIVE  0xFEFF
 #define UNICODE_BOM_SWAPPED 0xFFFE
 #define UNICODE_NEW_LINE    0x000A
 
+#define FONT_ATLAS_SIZE 512
+
 int
 Font_Init();
 
@@ -18,20 +23,42 @@ char*
 Font_GetError();
 
 typedef struct {
-    unsigned char* buffer;
-    int height;
+    FontGlyphPixmap* glyph;
+    // pen position of the glyph, from the top left corner of the text
+    int x;
+    int y;
+} FontGlyphPlacement;
+
+// Glyphs of a string and the size it takes, measured in the same pass.
+typedef struct {
+    FontGlyphPlacement* placements;
+    int length;
+    int capacity;
     int width;
-    int y_offset;
-    int x_offset;
-    int advance_x;
-} FontGlyphPixmap;
+    int height;
+} FontLayout;
 
 typedef struct {
     PyObject_HEAD
     FT_Face face;
-    PyObject* glyph_cache;
+    GlyphStore glyphs;
+    // reused by every layout of the font
+    FontLayout layout;
+    // glyphs of the renderer that last drew the font
+    Atlas* atlas;
 } Font;
 
 extern PyTypeObject FontType;
 
+FontGlyphPixmap*
+load_pixmap(Font* self, int unicode);
+
+// Lays text out into self->layout, or returns -1 with an exception set.
+int
+Font_Layout(Font* self, PyObject* text);
+
+// Packs a glyph into the font atlas of a renderer on first use.
+int
+Font_AtlasGlyph(Font* self, Renderer* renderer, FontGlyphPixmap* glyph);
+
 #endif /* FONT_H */
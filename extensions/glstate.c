@@ -0,0 +1,145 @@
+#include <string.h>
+
+#include "glstate.h"
+#include "batch.h"
+#include "opengl.h"
+
+static const GLenum GLState_Arrays[] = {GL_VERTEX_ARRAY, GL_COLOR_ARRAY, GL_TEXTURE_COORD_ARRAY};
+
+void
+GLState_Init(GLState* state) {
+    GLState_Invalidate(state);
+    state->issued = 0;
+    state->skipped = 0;
+}
+
+void
+GLState_Invalidate(GLState* state) {
+    // no call sets these, so the next one of every kind goes through
+    state->texture = (GLuint)-1;
+    state->program = (GLuint)-1;
+    state->blend = -1;
+    state->line_width = -1.0f;
+    state->line_smooth = -1;
+    state->client_arrays = -1;
+    state->color_known = 0;
+}
+
+void
+GLState_BindTexture(GLState* state, GLuint texture) {
+    if (state->texture == texture) {
+        state->skipped++;
+        return;
+    }
+    glBindTexture(GL_TEXTURE_2D, texture);
+    state->texture = texture;
+    state->issued++;
+}
+
+void
+GLState_DeleteTexture(GLState* state, GLuint texture) {
+    if (state->texture == texture) {
+        state->texture = 0;
+    }
+}
+
+void
+GLState_UseProgram(GLState* state, GLuint program) {
+    if (state->program == program) {
+        state->skipped++;
+        return;
+    }
+    glUseProgram(program);
+    state->program = program;
+    state->issued++;
+}
+
+void
+GLState_Blend(GLState* state, int blend) {
+    if (state->blend == blend) {
+        state->skipped++;
+        return;
+    }
+    switch (blend) {
+        case BATCH_BLEND_NONE:
+            glDisable(GL_BLEND);
+            break;
+        case BATCH_BLEND_ADDITIVE:
+            glBlendFunc(GL_SRC_ALPHA, GL_ONE);
+            glEnable(GL_BLEND);
+            break;
+        default:
+            glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+            glEnable(GL_BLEND);
+            break;
+    }
+    state->blend = blend;
+    state->issued++;
+}
+
+void
+GLState_LineWidth(GLState* state, GLfloat width) {
+    if (state->line_width == width) {
+        state->skipped++;
+        return;
+    }
+    glLineWidth(width);
+    state->line_width = width;
+    state->issued++;
+}
+
+void
+GLState_LineSmooth(GLState* state, int smooth) {
+    smooth = smooth != 0;
+    if (state->line_smooth == smooth) {
+        state->skipped++;
+        return;
+    }
+    if (smooth) {
+        glEnable(GL_LINE_SMOOTH);
+    }
+    else {
+        glDisable(GL_LINE_SMOOTH);
+    }
+    state->line_smooth = smooth;
+    state->issued++;
+}
+
+void
+GLState_ClientArrays(GLState* state, int mask) {
+    if (state->client_arrays == mask) {
+        state->skipped++;
+        return;
+    }
+    for (int i = 0; i < 3; i++) {
+        int bit = 1 << i;
+        if (state->client_arrays >= 0 && (state->client_arrays & bit) == (mask & bit)) {
+            continue;
+        }
+        if (mask & bit) {
+            glEnableClientState(GLState_Arrays[i]);
+        }
+        else {
+            glDisableClientState(GLState_Arrays[i]);
+        }
+        state->issued++;
+    }
+    // drawing with a color array leaves the current color undefined
+    if (mask & GLSTATE_COLOR_ARRAY) {
+        state->color_known = 0;
+    }
+    state->client_arrays = mask;
+}
+
+void
+GLState_Color(GLState* state, const GLubyte* color) {
+    if (state->color_known && memcmp(state->color, color, 4) == 0) {
+        state->skipped++;
+        return;
+    }
+    glColor4ubv(color);
+    memcpy(state->color, color, 4);
+    // until the next draw, if the color array is still enabled
+    state->color_known = state->client_arrays < 0 || ! (state->client_arrays & GLSTATE_COLOR_ARRAY);
+    state->issued++;
+}
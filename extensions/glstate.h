@@ -0,0 +1,67 @@
+#ifndef GLSTATE_H
+#define GLSTATE_H
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_opengl.h>
+
+// Fixed function client arrays, as a mask for GLState_ClientArrays.
+#define GLSTATE_VERTEX_ARRAY        1
+#define GLSTATE_COLOR_ARRAY         2
+#define GLSTATE_TEXTURE_COORD_ARRAY 4
+
+// Shadow of the OpenGL state of one context that draws change most, so
+// calls that would set what is already set are skipped. Values that are
+// not known, e.g. right after the context was made, are always set.
+// Only touched while that context is current, see Renderer_MakeCurrent.
+typedef struct {
+    GLuint texture;
+    GLuint program;
+    int blend;
+    GLfloat line_width;
+    int line_smooth;
+    int client_arrays;
+    GLubyte color[4];
+    int color_known;
+    unsigned long issued;
+    unsigned long skipped;
+} GLState;
+
+void
+GLState_Init(GLState* state);
+
+// Forgets every value, for code that changed the state behind its back.
+void
+GLState_Invalidate(GLState* state);
+
+void
+GLState_BindTexture(GLState* state, GLuint texture);
+
+// Deleted textures are unbound by OpenGL itself.
+void
+GLState_DeleteTexture(GLState* state, GLuint texture);
+
+void
+GLState_UseProgram(GLState* state, GLuint program);
+
+// One of the BATCH_BLEND_* modes.
+void
+GLState_Blend(GLState* state, int blend);
+
+void
+GLState_LineWidth(GLState* state, GLfloat width);
+
+void
+GLState_LineSmooth(GLState* state, int smooth);
+
+// Enables exactly the client arrays in mask and disables the others.
+void
+GLState_ClientArrays(GLState* state, int mask);
+
+void
+GLState_Color(GLState* state, const GLubyte* color);
+
+#endif /* GLSTATE_H */
@@ -0,0 +1,152 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "glyphs.h"
+
+#define GLYPHS_ALIGNMENT 16
+
+// Fibonacci hashing spreads consecutive code points over the table.
+static Uint32
+GlyphStore_Slot(Uint32 unicode, int capacity) {
+    return (unicode * 2654435761u) & (Uint32)(capacity - 1);
+}
+
+void
+GlyphStore_Init(GlyphStore* store) {
+    memset(store, 0, sizeof(GlyphStore));
+}
+
+void
+GlyphStore_Free(GlyphStore* store) {
+    GlyphSlab* slab = store->slabs;
+    while (slab != NULL) {
+        GlyphSlab* next = slab->next;
+        free(slab);
+        slab = next;
+    }
+    for (int i = 0; i < GLYPHS_DIRECT_LIMIT / GLYPHS_PAGE_SIZE; i++) {
+        free(store->pages[i]);
+    }
+    free(store->keys);
+    free(store->values);
+    GlyphStore_Init(store);
+}
+
+FontGlyphPixmap*
+GlyphStore_Get(const GlyphStore* store, Uint32 unicode) {
+    if (unicode < GLYPHS_DIRECT_LIMIT) {
+        FontGlyphPixmap** page = store->pages[unicode / GLYPHS_PAGE_SIZE];
+        return page != NULL ? page[unicode % GLYPHS_PAGE_SIZE] : NULL;
+    }
+    if (store->capacity == 0) {
+        return NULL;
+    }
+    // code points past the direct table are never 0, which marks free slots
+    for (Uint32 i = GlyphStore_Slot(unicode, store->capacity); store->keys[i] != 0; i = (i + 1) & (store->capacity - 1)) {
+        if (store->keys[i] == unicode) {
+            return store->values[i];
+        }
+    }
+    return NULL;
+}
+
+static void
+GlyphStore_Place(Uint32* keys, FontGlyphPixmap** values, int capacity, Uint32 unicode, FontGlyphPixmap* glyph) {
+    Uint32 i = GlyphStore_Slot(unicode, capacity);
+    while (keys[i] != 0) {
+        i = (i + 1) & (capacity - 1);
+    }
+    keys[i] = unicode;
+    values[i] = glyph;
+}
+
+// Keeps the table at most half full, so probes stay short.
+static int
+GlyphStore_Reserve(GlyphStore* store) {
+    Uint32* keys;
+    FontGlyphPixmap** values;
+    int capacity;
+    if ((store->length + 1) * 2 <= store->capacity) {
+        return 0;
+    }
+    capacity = store->capacity ? store->capacity * 2 : 64;
+    keys = (Uint32*)calloc(capacity, sizeof(Uint32));
+    values = (FontGlyphPixmap**)malloc(capacity * sizeof(FontGlyphPixmap*));
+    if (keys == NULL || values == NULL) {
+        free(keys);
+        free(values);
+        return -1;
+    }
+    for (int i = 0; i < store->capacity; i++) {
+        if (store->keys[i] != 0) {
+            GlyphStore_Place(keys, values, capacity, store->keys[i], store->values[i]);
+        }
+    }
+    free(store->keys);
+    free(store->values);
+    store->keys = keys;
+    store->values = values;
+    store->capacity = capacity;
+    return 0;
+}
+
+static void*
+GlyphStore_Allocate(GlyphStore* store, size_t size) {
+    GlyphSlab* slab = store->slabs;
+    size_t header = (sizeof(GlyphSlab) + GLYPHS_ALIGNMENT - 1) & ~(size_t)(GLYPHS_ALIGNMENT - 1);
+    void* memory;
+    size = (size + GLYPHS_ALIGNMENT - 1) & ~(size_t)(GLYPHS_ALIGNMENT - 1);
+    if (slab == NULL || slab->used + size > slab->capacity) {
+        // glyphs bigger than a slab get one of their own
+        size_t capacity = size > GLYPHS_SLAB_SIZE ? size : GLYPHS_SLAB_SIZE;
+        slab = (GlyphSlab*)malloc(header + capacity);
+        if (slab == NULL) {
+            return NULL;
+        }
+        slab->used = 0;
+        slab->capacity = capacity;
+        slab->next = store->slabs;
+        store->slabs = slab;
+    }
+    memory = (unsigned char*)slab + header + slab->used;
+    slab->used += size;
+    return memory;
+}
+
+FontGlyphPixmap*
+GlyphStore_Add(GlyphStore* store, Uint32 unicode, int width, int height) {
+    FontGlyphPixmap* glyph;
+    if (unicode < GLYPHS_DIRECT_LIMIT) {
+        FontGlyphPixmap*** page = &store->pages[unicode / GLYPHS_PAGE_SIZE];
+        if (*page == NULL) {
+            *page = (FontGlyphPixmap**)calloc(GLYPHS_PAGE_SIZE, sizeof(FontGlyphPixmap*));
+            if (*page == NULL) {
+                return NULL;
+            }
+        }
+    }
+    else if (GlyphStore_Reserve(store) != 0) {
+        return NULL;
+    }
+    glyph = (FontGlyphPixmap*)GlyphStore_Allocate(store, sizeof(FontGlyphPixmap));
+    if (glyph == NULL) {
+        return NULL;
+    }
+    glyph->buffer = (unsigned char*)GlyphStore_Allocate(store, (size_t)width * height + GLYPHS_PADDING);
+    if (glyph->buffer == NULL) {
+        return NULL;
+    }
+    glyph->width = width;
+    glyph->height = height;
+    glyph->texture = 0;
+    glyph->next = store->first;
+    store->first = glyph;
+    if (unicode < GLYPHS_DIRECT_LIMIT) {
+        store->pages[unicode / GLYPHS_PAGE_SIZE][unicode % GLYPHS_PAGE_SIZE] = glyph;
+    }
+    else {
+        GlyphStore_Place(store->keys, store->values, store->capacity, unicode, glyph);
+        store->length++;
+    }
+    return glyph;
+}
@@ -0,0 +1,67 @@
+#ifndef GLYPHS_H
+#define GLYPHS_H
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_opengl.h>
+
+// Code points below this are looked up directly, in pages of 256.
+#define GLYPHS_DIRECT_LIMIT 0x10000
+#define GLYPHS_PAGE_SIZE    256
+#define GLYPHS_SLAB_SIZE    65536
+// readable bytes past every bitmap, so blits can load whole vectors
+#define GLYPHS_PADDING      16
+
+typedef struct FontGlyphPixmap {
+    unsigned char* buffer;
+    int height;
+    int width;
+    int y_offset;
+    int x_offset;
+    int advance_x;
+    // where the glyph went in the font atlas, 0 until first drawn
+    GLuint texture;
+    int atlas_x;
+    int atlas_y;
+    // every glyph of the store, newest first
+    struct FontGlyphPixmap* next;
+} FontGlyphPixmap;
+
+typedef struct GlyphSlab {
+    struct GlyphSlab* next;
+    size_t used;
+    size_t capacity;
+} GlyphSlab;
+
+// Rendered glyphs of a font by code point. The Basic Multilingual Plane
+// is indexed directly, other planes go through an open addressing table,
+// and every glyph lives in a few slabs freed at once.
+typedef struct {
+    FontGlyphPixmap** pages[GLYPHS_DIRECT_LIMIT / GLYPHS_PAGE_SIZE];
+    Uint32* keys;
+    FontGlyphPixmap** values;
+    int length;
+    int capacity;
+    GlyphSlab* slabs;
+    FontGlyphPixmap* first;
+} GlyphStore;
+
+void
+GlyphStore_Init(GlyphStore* store);
+
+void
+GlyphStore_Free(GlyphStore* store);
+
+// Returns the glyph of a code point, or NULL when it was never added.
+FontGlyphPixmap*
+GlyphStore_Get(const GlyphStore* store, Uint32 unicode);
+
+// Adds a glyph with room for a width x height bitmap, or returns NULL when
+// out of memory.
+FontGlyphPixmap*
+GlyphStore_Add(GlyphStore* store, Uint32 unicode, int width, int height);
+
+#endif /* GLYPHS_H */
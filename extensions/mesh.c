@@ -0,0 +1,191 @@
+#include "mesh.h"
+#include "coordinates.h"
+#include "opengl.h"
+
+static int
+Mesh_init(Mesh* self, PyObject* args, PyObject* kwargs) {
+    PyObject* renderer;
+    PyObject* object;
+    Coordinates coordinates;
+    const GLvoid* data;
+    GLfloat* vertices;
+    GLenum type;
+    int format;
+    if (! PyArg_ParseTuple(args, "O!O", &RendererType, &renderer, &object)) {
+        return -1;
+    }
+    if (self->renderer != NULL && self->renderer != (Renderer*)renderer) {
+        PyErr_SetString(PyExc_RuntimeError, "mesh belongs to another renderer");
+        return -1;
+    }
+    if (Renderer_MakeCurrent((Renderer*)renderer) != 0) {
+        return -1;
+    }
+    format = ((Renderer*)renderer)->vertex_format;
+    if (Coordinates_FromObject(object, format, &coordinates) != 0) {
+        return -1;
+    }
+    if (coordinates.length % 2 != 0) {
+        Coordinates_Release(&coordinates);
+        PyErr_SetString(PyExc_ValueError, "coordinates must be a sequence of float values (x0, y0, x1, y1 ...)");
+        return -1;
+    }
+    // stored in the renderer vertex format, whatever the input was
+    if (format == COORDINATES_INT16) {
+        type = GL_SHORT;
+        data = Coordinates_AsShorts(&coordinates);
+    }
+    else {
+        type = GL_FLOAT;
+        data = Coordinates_AsFloats(&coordinates);
+    }
+    if (data == NULL) {
+        Coordinates_Release(&coordinates);
+        return -1;
+    }
+
+    // a CPU copy for paths that expand the mesh themselves
+    vertices = (GLfloat*)malloc((coordinates.length ? coordinates.length : 1) * sizeof(GLfloat));
+    if (vertices == NULL) {
+        Coordinates_Release(&coordinates);
+        PyErr_NoMemory();
+        return -1;
+    }
+    for (Py_ssize_t i = 0; i < coordinates.length; i++) {
+        vertices[i] = type == GL_SHORT ? (GLfloat)((const GLshort*)data)[i] : ((const GLfloat*)data)[i];
+    }
+    free(self->vertices);
+    self->vertices = vertices;
+    free(self->indices);
+    self->indices = NULL;
+    self->index_count = 0;
+
+    Py_XDECREF(self->renderer);
+    self->renderer = (Renderer*)renderer;
+    Py_INCREF(self->renderer);
+    if (self->buffer == 0) {
+        glGenBuffers(1, &self->buffer);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, self->buffer);
+    glBufferData(GL_ARRAY_BUFFER, coordinates.length * (type == GL_SHORT ? sizeof(GLshort) : sizeof(GLfloat)), data, GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    self->type = type;
+    self->length = (int)(coordinates.length / 2);
+    Coordinates_Release(&coordinates);
+    return 0;
+}
+
+int
+Mesh_Triangulate(Mesh* self) {
+    GLuint* indices;
+    int count;
+    if (self->indices != NULL) {
+        return 0;
+    }
+    indices = (GLuint*)malloc((self->length > 2 ? (self->length - 2) * 3 : 1) * sizeof(GLuint));
+    if (indices == NULL) {
+        PyErr_NoMemory();
+        return -1;
+    }
+    count = Triangulate_Polygon(self->vertices, self->length, indices);
+    if (count < 0) {
+        free(indices);
+        PyErr_NoMemory();
+        return -1;
+    }
+    if (self->index_buffer == 0) {
+        glGenBuffers(1, &self->index_buffer);
+    }
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, self->index_buffer);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, count * sizeof(GLuint), indices, GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    self->indices = indices;
+    self->index_count = count;
+    return 0;
+}
+
+static void
+Mesh_dealloc(Mesh* self) {
+    Renderer* previous = Renderer_GetCurrent();
+    // buffers only have names in the context of their renderer, and when
+    // that can't be made current they are gone with it
+    if (self->renderer != NULL && Renderer_MakeCurrent(self->renderer) == 0) {
+        if (self->buffer != 0) {
+            glDeleteBuffers(1, &self->buffer);
+        }
+        if (self->index_buffer != 0) {
+            glDeleteBuffers(1, &self->index_buffer);
+        }
+    }
+    else if (self->renderer != NULL) {
+        PyErr_Clear();
+    }
+    if (previous != NULL && previous != self->renderer && Renderer_MakeCurrent(previous) != 0) {
+        PyErr_Clear();
+    }
+    free(self->indices);
+    free(self->vertices);
+    Py_XDECREF(self->renderer);
+    Py_TYPE(self)->tp_free((PyObject*)self);
+}
+
+static PyObject*
+Mesh_get_length(Mesh* self, void* closure) {
+    return PyLong_FromLong(self->length);
+}
+
+static PyGetSetDef Mesh_getsetters[] = {
+    {
+        "length",
+        (getter)Mesh_get_length,
+        NULL,
+        "Number of vertices stored in the mesh.",
+        NULL
+    },
+    {NULL}
+};
+
+static PyMethodDef Mesh_methods[] = {
+    {NULL}
+};
+
+PyTypeObject MeshType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "wutu._graphics.Mesh",
+    sizeof(Mesh),
+    0,                         /* tp_itemsize */
+    (destructor)Mesh_dealloc,
+    0,                         /* tp_print */
+    0,                         /* tp_getattr */
+    0,                         /* tp_setattr */
+    0,                         /* tp_reserved */
+    0,                         /* tp_repr */
+    0,                         /* tp_as_number */
+    0,                         /* tp_as_sequence */
+    0,                         /* tp_as_mapping */
+    0,                         /* tp_hash  */
+    0,                         /* tp_call */
+    0,                         /* tp_str */
+    0,                         /* tp_getattro */
+    0,                         /* tp_setattro */
+    0,                         /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE,
+    "Represents vertex coordinates stored in a GPU buffer of a rendering context.",
+    0,                         /* tp_traverse */
+    0,                         /* tp_clear */
+    0,                         /* tp_richcompare */
+    0,                         /* tp_weaklistoffset */
+    0,                         /* tp_iter */
+    0,                         /* tp_iternext */
+    Mesh_methods,
+    0,                         /* tp_members */
+    Mesh_getsetters,
+    0,
+    0,                         /* tp_dict */
+    0,                         /* tp_descr_get */
+    0,                         /* tp_descr_set */
+    0,                         /* tp_dictoffset */
+    (initproc)Mesh_init,
+    0,                         /* tp_alloc */
+    (newfunc)PyType_GenericNew
+};
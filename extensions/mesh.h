@@ -0,0 +1,34 @@
+#ifndef MESH_H
+#define MESH_H
+
+#include <Python.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_opengl.h>
+
+#include "renderer.h"
+
+typedef struct {
+    PyObject_HEAD
+    Renderer* renderer;
+    GLuint buffer;
+    GLenum type;
+    int length;
+    GLfloat* vertices;
+    // triangles of the outline, made the first time it is filled
+    GLuint* indices;
+    int index_count;
+    GLuint index_buffer;
+} Mesh;
+
+extern PyTypeObject MeshType;
+
+// Triangulates the mesh outline into indices and index_buffer, once.
+int
+Mesh_Triangulate(Mesh* self);
+
+#endif /* MESH_H */
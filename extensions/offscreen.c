@@ -0,0 +1,243 @@
+#include "offscreen.h"
+
+#ifdef WUTU_EGL
+
+#include <string.h>
+
+#include <EGL/eglext.h>
+
+static int
+Offscreen_HasExtension(const char* extensions, const char* name) {
+    size_t length = strlen(name);
+    while (extensions != NULL && (extensions = strstr(extensions, name)) != NULL) {
+        if (extensions[length] == ' ' || extensions[length] == '\0') {
+            return 1;
+        }
+        extensions += length;
+    }
+    return 0;
+}
+
+static void*
+Offscreen_Load(const char* name) {
+    return (void*)eglGetProcAddress(name);
+}
+
+static int
+OffscreenRenderer_MakeCurrent(Renderer* renderer) {
+    OffscreenRenderer* self = (OffscreenRenderer*)renderer;
+    if (! eglMakeCurrent(self->display, self->surface, self->surface, self->context)) {
+        PyErr_Format(PyExc_RuntimeError, "EGL context can't be made current (error 0x%x)", eglGetError());
+        return -1;
+    }
+    return 0;
+}
+
+// Prefers Mesa's surfaceless platform, which works without any window
+// system, over the default display.
+static EGLDisplay
+Offscreen_GetDisplay() {
+    const char* extensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+    EGLDisplay display;
+    if (Offscreen_HasExtension(extensions, "EGL_EXT_platform_base") &&
+        Offscreen_HasExtension(extensions, "EGL_MESA_platform_surfaceless")) {
+        PFNEGLGETPLATFORMDISPLAYEXTPROC get_platform_display;
+        get_platform_display = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+        if (get_platform_display != NULL) {
+            display = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+            if (display != EGL_NO_DISPLAY && eglInitialize(display, NULL, NULL)) {
+                return display;
+            }
+        }
+    }
+    display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    if (display != EGL_NO_DISPLAY && eglInitialize(display, NULL, NULL)) {
+        return display;
+    }
+    return EGL_NO_DISPLAY;
+}
+
+static int
+OffscreenRenderer_CreateContext(OffscreenRenderer* self, int backend) {
+    EGLint config_attributes[] = {
+        EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+        EGL_NONE
+    };
+    EGLint core_attributes[] = {
+        EGL_CONTEXT_MAJOR_VERSION_KHR, 3,
+        EGL_CONTEXT_MINOR_VERSION_KHR, 3,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK_KHR, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT_KHR,
+        EGL_NONE
+    };
+    EGLint pbuffer_attributes[] = {EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE};
+    EGLConfig config;
+    EGLint count = 0;
+    int surfaceless;
+    self->display = Offscreen_GetDisplay();
+    if (self->display == EGL_NO_DISPLAY) {
+        PyErr_Format(PyExc_RuntimeError, "EGL display is not available (error 0x%x)", eglGetError());
+        return -1;
+    }
+    // everything is drawn into a framebuffer object, the surface only has
+    // to exist where contexts can't be current without one
+    surfaceless = Offscreen_HasExtension(eglQueryString(self->display, EGL_EXTENSIONS), "EGL_KHR_surfaceless_context");
+    if (surfaceless) {
+        config_attributes[1] = 0;
+    }
+    if (! eglBindAPI(EGL_OPENGL_API) ||
+        ! eglChooseConfig(self->display, config_attributes, &config, 1, &count) || count == 0) {
+        PyErr_SetString(PyExc_RuntimeError, "EGL has no configuration for desktop OpenGL");
+        return -1;
+    }
+    self->context = eglCreateContext(self->display, config, EGL_NO_CONTEXT,
+        backend == RENDERER_BACKEND_CORE ? core_attributes : NULL);
+    if (self->context == EGL_NO_CONTEXT) {
+        PyErr_Format(PyExc_RuntimeError, "EGL context can't be created (error 0x%x)", eglGetError());
+        return -1;
+    }
+    if (! surfaceless) {
+        self->surface = eglCreatePbufferSurface(self->display, config, pbuffer_attributes);
+        if (self->surface == EGL_NO_SURFACE) {
+            PyErr_Format(PyExc_RuntimeError, "EGL pbuffer can't be created (error 0x%x)", eglGetError());
+            return -1;
+        }
+    }
+    return OffscreenRenderer_MakeCurrent(&self->renderer);
+}
+
+#endif /* WUTU_EGL */
+
+int
+Offscreen_IsSupported() {
+#ifdef WUTU_EGL
+    return 1;
+#else
+    return 0;
+#endif
+}
+
+static int
+OffscreenRenderer_CreateFramebuffer(OffscreenRenderer* self) {
+    if (! OpenGL_HasFramebuffers) {
+        PyErr_SetString(PyExc_RuntimeError, "OpenGL framebuffer objects are not available");
+        return -1;
+    }
+    glGenRenderbuffers(1, &self->colorbuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, self->colorbuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, self->renderer.width, self->renderer.height);
+    glGenFramebuffers(1, &self->framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, self->framebuffer);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, self->colorbuffer);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        PyErr_SetString(PyExc_RuntimeError, "offscreen framebuffer is not complete");
+        return -1;
+    }
+    // stays bound, there is nothing else to draw into
+    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    return 0;
+}
+
+static int
+OffscreenRenderer_init(OffscreenRenderer* self, PyObject* args, PyObject* kwargs) {
+    int width, height, backend = RENDERER_BACKEND_LEGACY;
+    if (! PyArg_ParseTuple(args, "ii|i", &width, &height, &backend)) {
+        return -1;
+    }
+    if (width <= 0 || height <= 0) {
+        PyErr_SetString(PyExc_ValueError, "offscreen renderer size must be positive");
+        return -1;
+    }
+#ifdef WUTU_EGL
+    if (Renderer_InitState(&self->renderer, width, height, backend) != 0) {
+        return -1;
+    }
+    self->renderer.make_current = OffscreenRenderer_MakeCurrent;
+    if (OffscreenRenderer_CreateContext(self, backend) != 0) {
+        return -1;
+    }
+    if (Renderer_InitPipeline(&self->renderer, Offscreen_Load) != 0) {
+        return -1;
+    }
+    return OffscreenRenderer_CreateFramebuffer(self);
+#else
+    PyErr_SetString(PyExc_RuntimeError, "offscreen rendering is not supported on this platform");
+    return -1;
+#endif
+}
+
+static void
+OffscreenRenderer_dealloc(OffscreenRenderer* self) {
+    Renderer* previous = Renderer_GetCurrent();
+#ifdef WUTU_EGL
+    EGLDisplay display = self->display;
+    EGLContext context = self->context;
+    EGLSurface surface = self->surface;
+    if (context != EGL_NO_CONTEXT && Renderer_MakeCurrent(&self->renderer) != 0) {
+        PyErr_Clear();
+    }
+#endif
+    if (self->framebuffer != 0) {
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glDeleteFramebuffers(1, &self->framebuffer);
+    }
+    if (self->colorbuffer != 0) {
+        glDeleteRenderbuffers(1, &self->colorbuffer);
+    }
+    // frees the object, so the handles above were copied
+    RendererType.tp_dealloc((PyObject*)self);
+#ifdef WUTU_EGL
+    if (context != EGL_NO_CONTEXT) {
+        eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        eglDestroyContext(display, context);
+    }
+    if (surface != EGL_NO_SURFACE) {
+        eglDestroySurface(display, surface);
+    }
+#endif
+    if (previous != NULL && previous != (Renderer*)self && Renderer_MakeCurrent(previous) != 0) {
+        PyErr_Clear();
+    }
+}
+
+PyTypeObject OffscreenRendererType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "wutu._graphics.OffscreenRenderer",
+    sizeof(OffscreenRenderer),
+    0,                         /* tp_itemsize */
+    (destructor)OffscreenRenderer_dealloc,
+    0,                         /* tp_print */
+    0,                         /* tp_getattr */
+    0,                         /* tp_setattr */
+    0,                         /* tp_reserved */
+    0,                         /* tp_repr */
+    0,                         /* tp_as_number */
+    0,                         /* tp_as_sequence */
+    0,                         /* tp_as_mapping */
+    0,                         /* tp_hash  */
+    0,                         /* tp_call */
+    0,                         /* tp_str */
+    0,                         /* tp_getattro */
+    0,                         /* tp_setattro */
+    0,                         /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE,
+    "Renders into an offscreen framebuffer, without a window or display.",
+    0,                         /* tp_traverse */
+    0,                         /* tp_clear */
+    0,                         /* tp_richcompare */
+    0,                         /* tp_weaklistoffset */
+    0,                         /* tp_iter */
+    0,                         /* tp_iternext */
+    0,                         /* tp_methods */
+    0,                         /* tp_members */
+    0,                         /* tp_getset */
+    &RendererType,             /* tp_base */
+    0,                         /* tp_dict */
+    0,                         /* tp_descr_get */
+    0,                         /* tp_descr_set */
+    0,                         /* tp_dictoffset */
+    (initproc)OffscreenRenderer_init,
+    0,                         /* tp_alloc */
+    (newfunc)PyType_GenericNew
+};
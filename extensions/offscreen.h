@@ -0,0 +1,37 @@
+#ifndef OFFSCREEN_H
+#define OFFSCREEN_H
+
+#include <Python.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_opengl.h>
+
+#ifdef WUTU_EGL
+#include <EGL/egl.h>
+#endif
+
+#include "renderer.h"
+
+// Renderer drawing into a framebuffer object of its own headless context,
+// so no display or window is needed.
+typedef struct {
+    Renderer renderer;
+#ifdef WUTU_EGL
+    EGLDisplay display;
+    EGLContext context;
+    EGLSurface surface;
+#endif
+    GLuint framebuffer;
+    GLuint colorbuffer;
+} OffscreenRenderer;
+
+extern PyTypeObject OffscreenRendererType;
+
+int
+Offscreen_IsSupported();
+
+#endif /* OFFSCREEN_H */
@@ -0,0 +1,229 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "opengl.h"
+
+static const char* missing = NULL;
+static OpenGL_Loader load = NULL;
+static PFNGLGETSTRINGIPROC OpenGL_GetStringi;
+
+PFNGLGENBUFFERSPROC OpenGL_GenBuffers;
+PFNGLDELETEBUFFERSPROC OpenGL_DeleteBuffers;
+PFNGLBINDBUFFERPROC OpenGL_BindBuffer;
+PFNGLBUFFERDATAPROC OpenGL_BufferData;
+PFNGLBUFFERSUBDATAPROC OpenGL_BufferSubData;
+PFNGLMAPBUFFERPROC OpenGL_MapBuffer;
+PFNGLUNMAPBUFFERPROC OpenGL_UnmapBuffer;
+
+PFNGLCREATESHADERPROC OpenGL_CreateShader;
+PFNGLDELETESHADERPROC OpenGL_DeleteShader;
+PFNGLSHADERSOURCEPROC OpenGL_ShaderSource;
+PFNGLCOMPILESHADERPROC OpenGL_CompileShader;
+PFNGLGETSHADERIVPROC OpenGL_GetShaderiv;
+PFNGLGETSHADERINFOLOGPROC OpenGL_GetShaderInfoLog;
+PFNGLCREATEPROGRAMPROC OpenGL_CreateProgram;
+PFNGLDELETEPROGRAMPROC OpenGL_DeleteProgram;
+PFNGLATTACHSHADERPROC OpenGL_AttachShader;
+PFNGLBINDATTRIBLOCATIONPROC OpenGL_BindAttribLocation;
+PFNGLLINKPROGRAMPROC OpenGL_LinkProgram;
+PFNGLGETPROGRAMIVPROC OpenGL_GetProgramiv;
+PFNGLGETPROGRAMINFOLOGPROC OpenGL_GetProgramInfoLog;
+PFNGLUSEPROGRAMPROC OpenGL_UseProgram;
+PFNGLGETUNIFORMLOCATIONPROC OpenGL_GetUniformLocation;
+PFNGLUNIFORM1IPROC OpenGL_Uniform1i;
+PFNGLUNIFORMMATRIX4FVPROC OpenGL_UniformMatrix4fv;
+PFNGLVERTEXATTRIB2FPROC OpenGL_VertexAttrib2f;
+PFNGLVERTEXATTRIB4FPROC OpenGL_VertexAttrib4f;
+PFNGLENABLEVERTEXATTRIBARRAYPROC OpenGL_EnableVertexAttribArray;
+PFNGLDISABLEVERTEXATTRIBARRAYPROC OpenGL_DisableVertexAttribArray;
+PFNGLVERTEXATTRIBPOINTERPROC OpenGL_VertexAttribPointer;
+
+PFNGLDRAWARRAYSINSTANCEDPROC OpenGL_DrawArraysInstanced;
+PFNGLDRAWELEMENTSINSTANCEDPROC OpenGL_DrawElementsInstanced;
+PFNGLVERTEXATTRIBDIVISORPROC OpenGL_VertexAttribDivisor;
+
+PFNGLGENVERTEXARRAYSPROC OpenGL_GenVertexArrays;
+PFNGLDELETEVERTEXARRAYSPROC OpenGL_DeleteVertexArrays;
+PFNGLBINDVERTEXARRAYPROC OpenGL_BindVertexArray;
+
+int OpenGL_HasShaders = 0;
+int OpenGL_HasInstancing = 0;
+PFNGLGENFRAMEBUFFERSPROC OpenGL_GenFramebuffers;
+PFNGLDELETEFRAMEBUFFERSPROC OpenGL_DeleteFramebuffers;
+PFNGLBINDFRAMEBUFFERPROC OpenGL_BindFramebuffer;
+PFNGLFRAMEBUFFERRENDERBUFFERPROC OpenGL_FramebufferRenderbuffer;
+PFNGLCHECKFRAMEBUFFERSTATUSPROC OpenGL_CheckFramebufferStatus;
+PFNGLGENRENDERBUFFERSPROC OpenGL_GenRenderbuffers;
+PFNGLDELETERENDERBUFFERSPROC OpenGL_DeleteRenderbuffers;
+PFNGLBINDRENDERBUFFERPROC OpenGL_BindRenderbuffer;
+PFNGLRENDERBUFFERSTORAGEPROC OpenGL_RenderbufferStorage;
+PFNGLGENERATEMIPMAPPROC OpenGL_GenerateMipmap;
+
+PFNGLFENCESYNCPROC OpenGL_FenceSync;
+PFNGLCLIENTWAITSYNCPROC OpenGL_ClientWaitSync;
+PFNGLDELETESYNCPROC OpenGL_DeleteSync;
+
+int OpenGL_HasVertexArrays = 0;
+int OpenGL_HasFramebuffers = 0;
+int OpenGL_HasPixelBuffers = 0;
+int OpenGL_HasSync = 0;
+
+static void*
+OpenGL_Load(const char* name, int* available) {
+    void* function = load(name);
+    if (function == NULL) {
+        *available = 0;
+        if (missing == NULL) {
+            missing = name;
+        }
+    }
+    return function;
+}
+
+// Tries the core name first and the ARB extension name second.
+static void*
+OpenGL_LoadEither(const char* name, const char* extension_name, int* available) {
+    void* function = load(name);
+    if (function == NULL) {
+        function = load(extension_name);
+    }
+    if (function == NULL) {
+        *available = 0;
+    }
+    return function;
+}
+
+// Some loaders hand out stubs for any name, so the version has to agree too.
+static int
+OpenGL_Version() {
+    const char* version = (const char*)glGetString(GL_VERSION);
+    int major = 0, minor = 0;
+    if (version == NULL || sscanf(version, "%d.%d", &major, &minor) != 2) {
+        return 0;
+    }
+    return major * 10 + minor;
+}
+
+// Not SDL_GL_ExtensionSupported, which needs the SDL video subsystem even
+// for contexts that SDL did not create.
+static int
+OpenGL_HasExtension(const char* name, int version) {
+    const char* extensions;
+    size_t length = strlen(name);
+    if (version >= 30 && OpenGL_GetStringi != NULL) {
+        GLint count = 0;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+        for (GLint i = 0; i < count; i++) {
+            const char* extension = (const char*)OpenGL_GetStringi(GL_EXTENSIONS, i);
+            if (extension != NULL && strcmp(extension, name) == 0) {
+                return 1;
+            }
+        }
+        return 0;
+    }
+    extensions = (const char*)glGetString(GL_EXTENSIONS);
+    while (extensions != NULL && (extensions = strstr(extensions, name)) != NULL) {
+        if (extensions[length] == ' ' || extensions[length] == '\0') {
+            return 1;
+        }
+        extensions += length;
+    }
+    return 0;
+}
+
+// Which groups of entry points the loader could find, over all contexts.
+static int loaded = 0;
+static int found_required = 1;
+static int found_shaders = 1;
+static int found_instancing = 1;
+static int found_vertex_arrays = 1;
+static int found_framebuffers = 1;
+static int found_sync = 1;
+
+// The pointers are process globals, so they are loaded with the first
+// context only; what each context supports is decided by OpenGL_Init.
+static void
+OpenGL_LoadFunctions() {
+    OpenGL_GetStringi = (PFNGLGETSTRINGIPROC)load("glGetStringi");
+    OpenGL_GenBuffers = (PFNGLGENBUFFERSPROC)OpenGL_Load("glGenBuffers", &found_required);
+    OpenGL_DeleteBuffers = (PFNGLDELETEBUFFERSPROC)OpenGL_Load("glDeleteBuffers", &found_required);
+    OpenGL_BindBuffer = (PFNGLBINDBUFFERPROC)OpenGL_Load("glBindBuffer", &found_required);
+    OpenGL_BufferData = (PFNGLBUFFERDATAPROC)OpenGL_Load("glBufferData", &found_required);
+    OpenGL_BufferSubData = (PFNGLBUFFERSUBDATAPROC)OpenGL_Load("glBufferSubData", &found_required);
+    OpenGL_MapBuffer = (PFNGLMAPBUFFERPROC)OpenGL_Load("glMapBuffer", &found_required);
+    OpenGL_UnmapBuffer = (PFNGLUNMAPBUFFERPROC)OpenGL_Load("glUnmapBuffer", &found_required);
+    OpenGL_CreateShader = (PFNGLCREATESHADERPROC)OpenGL_Load("glCreateShader", &found_shaders);
+    OpenGL_DeleteShader = (PFNGLDELETESHADERPROC)OpenGL_Load("glDeleteShader", &found_shaders);
+    OpenGL_ShaderSource = (PFNGLSHADERSOURCEPROC)OpenGL_Load("glShaderSource", &found_shaders);
+    OpenGL_CompileShader = (PFNGLCOMPILESHADERPROC)OpenGL_Load("glCompileShader", &found_shaders);
+    OpenGL_GetShaderiv = (PFNGLGETSHADERIVPROC)OpenGL_Load("glGetShaderiv", &found_shaders);
+    OpenGL_GetShaderInfoLog = (PFNGLGETSHADERINFOLOGPROC)OpenGL_Load("glGetShaderInfoLog", &found_shaders);
+    OpenGL_CreateProgram = (PFNGLCREATEPROGRAMPROC)OpenGL_Load("glCreateProgram", &found_shaders);
+    OpenGL_DeleteProgram = (PFNGLDELETEPROGRAMPROC)OpenGL_Load("glDeleteProgram", &found_shaders);
+    OpenGL_AttachShader = (PFNGLATTACHSHADERPROC)OpenGL_Load("glAttachShader", &found_shaders);
+    OpenGL_BindAttribLocation = (PFNGLBINDATTRIBLOCATIONPROC)OpenGL_Load("glBindAttribLocation", &found_shaders);
+    OpenGL_LinkProgram = (PFNGLLINKPROGRAMPROC)OpenGL_Load("glLinkProgram", &found_shaders);
+    OpenGL_GetProgramiv = (PFNGLGETPROGRAMIVPROC)OpenGL_Load("glGetProgramiv", &found_shaders);
+    OpenGL_GetProgramInfoLog = (PFNGLGETPROGRAMINFOLOGPROC)OpenGL_Load("glGetProgramInfoLog", &found_shaders);
+    OpenGL_UseProgram = (PFNGLUSEPROGRAMPROC)OpenGL_Load("glUseProgram", &found_shaders);
+    OpenGL_GetUniformLocation = (PFNGLGETUNIFORMLOCATIONPROC)OpenGL_Load("glGetUniformLocation", &found_shaders);
+    OpenGL_Uniform1i = (PFNGLUNIFORM1IPROC)OpenGL_Load("glUniform1i", &found_shaders);
+    OpenGL_UniformMatrix4fv = (PFNGLUNIFORMMATRIX4FVPROC)OpenGL_Load("glUniformMatrix4fv", &found_shaders);
+    OpenGL_EnableVertexAttribArray = (PFNGLENABLEVERTEXATTRIBARRAYPROC)OpenGL_Load("glEnableVertexAttribArray", &found_shaders);
+    OpenGL_DisableVertexAttribArray = (PFNGLDISABLEVERTEXATTRIBARRAYPROC)OpenGL_Load("glDisableVertexAttribArray", &found_shaders);
+    OpenGL_VertexAttribPointer = (PFNGLVERTEXATTRIBPOINTERPROC)OpenGL_Load("glVertexAttribPointer", &found_shaders);
+    OpenGL_VertexAttrib2f = (PFNGLVERTEXATTRIB2FPROC)OpenGL_Load("glVertexAttrib2f", &found_shaders);
+    OpenGL_VertexAttrib4f = (PFNGLVERTEXATTRIB4FPROC)OpenGL_Load("glVertexAttrib4f", &found_shaders);
+    OpenGL_DrawArraysInstanced = (PFNGLDRAWARRAYSINSTANCEDPROC)OpenGL_LoadEither("glDrawArraysInstanced", "glDrawArraysInstancedARB", &found_instancing);
+    OpenGL_DrawElementsInstanced = (PFNGLDRAWELEMENTSINSTANCEDPROC)OpenGL_LoadEither("glDrawElementsInstanced", "glDrawElementsInstancedARB", &found_instancing);
+    OpenGL_VertexAttribDivisor = (PFNGLVERTEXATTRIBDIVISORPROC)OpenGL_LoadEither("glVertexAttribDivisor", "glVertexAttribDivisorARB", &found_instancing);
+    OpenGL_GenVertexArrays = (PFNGLGENVERTEXARRAYSPROC)OpenGL_Load("glGenVertexArrays", &found_vertex_arrays);
+    OpenGL_DeleteVertexArrays = (PFNGLDELETEVERTEXARRAYSPROC)OpenGL_Load("glDeleteVertexArrays", &found_vertex_arrays);
+    OpenGL_BindVertexArray = (PFNGLBINDVERTEXARRAYPROC)OpenGL_Load("glBindVertexArray", &found_vertex_arrays);
+    OpenGL_GenFramebuffers = (PFNGLGENFRAMEBUFFERSPROC)OpenGL_Load("glGenFramebuffers", &found_framebuffers);
+    OpenGL_DeleteFramebuffers = (PFNGLDELETEFRAMEBUFFERSPROC)OpenGL_Load("glDeleteFramebuffers", &found_framebuffers);
+    OpenGL_BindFramebuffer = (PFNGLBINDFRAMEBUFFERPROC)OpenGL_Load("glBindFramebuffer", &found_framebuffers);
+    OpenGL_FramebufferRenderbuffer = (PFNGLFRAMEBUFFERRENDERBUFFERPROC)OpenGL_Load("glFramebufferRenderbuffer", &found_framebuffers);
+    OpenGL_CheckFramebufferStatus = (PFNGLCHECKFRAMEBUFFERSTATUSPROC)OpenGL_Load("glCheckFramebufferStatus", &found_framebuffers);
+    OpenGL_GenRenderbuffers = (PFNGLGENRENDERBUFFERSPROC)OpenGL_Load("glGenRenderbuffers", &found_framebuffers);
+    OpenGL_DeleteRenderbuffers = (PFNGLDELETERENDERBUFFERSPROC)OpenGL_Load("glDeleteRenderbuffers", &found_framebuffers);
+    OpenGL_BindRenderbuffer = (PFNGLBINDRENDERBUFFERPROC)OpenGL_Load("glBindRenderbuffer", &found_framebuffers);
+    OpenGL_RenderbufferStorage = (PFNGLRENDERBUFFERSTORAGEPROC)OpenGL_Load("glRenderbufferStorage", &found_framebuffers);
+    OpenGL_GenerateMipmap = (PFNGLGENERATEMIPMAPPROC)OpenGL_Load("glGenerateMipmap", &found_framebuffers);
+    OpenGL_FenceSync = (PFNGLFENCESYNCPROC)OpenGL_Load("glFenceSync", &found_sync);
+    OpenGL_ClientWaitSync = (PFNGLCLIENTWAITSYNCPROC)OpenGL_Load("glClientWaitSync", &found_sync);
+    OpenGL_DeleteSync = (PFNGLDELETESYNCPROC)OpenGL_Load("glDeleteSync", &found_sync);
+    loaded = 1;
+}
+
+int
+OpenGL_Init(OpenGL_Loader loader) {
+    int version = OpenGL_Version();
+    if (! loaded) {
+        load = loader;
+        OpenGL_LoadFunctions();
+    }
+    if (! found_required) {
+        return -1;
+    }
+    OpenGL_HasShaders = found_shaders && version >= 20;
+    OpenGL_HasInstancing = found_instancing && OpenGL_HasShaders && (version >= 33 || (
+        OpenGL_HasExtension("GL_ARB_draw_instanced", version) &&
+        OpenGL_HasExtension("GL_ARB_instanced_arrays", version)
+    ));
+    OpenGL_HasVertexArrays = found_vertex_arrays && OpenGL_HasShaders && (version >= 30 || OpenGL_HasExtension("GL_ARB_vertex_array_object", version));
+    OpenGL_HasFramebuffers = found_framebuffers && (version >= 30 || OpenGL_HasExtension("GL_ARB_framebuffer_object", version));
+    OpenGL_HasPixelBuffers = version >= 21 || OpenGL_HasExtension("GL_ARB_pixel_buffer_object", version);
+    OpenGL_HasSync = found_sync && (version >= 32 || OpenGL_HasExtension("GL_ARB_sync", version));
+    return 0;
+}
+
+char*
+OpenGL_GetError() {
+    static char message[128];
+    if (missing == NULL) {
+        return "no error";
+    }
+    snprintf(message, sizeof(message), "OpenGL function %s is not available", missing);
+    return message;
+}
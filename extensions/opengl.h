@@ -0,0 +1,150 @@
+#ifndef OPENGL_H
+#define OPENGL_H
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_opengl.h>
+
+// Entry points above OpenGL 1.1 are not exported by every system library
+// (opengl32.dll on Windows), so they are resolved once a context exists.
+
+extern PFNGLGENBUFFERSPROC OpenGL_GenBuffers;
+extern PFNGLDELETEBUFFERSPROC OpenGL_DeleteBuffers;
+extern PFNGLBINDBUFFERPROC OpenGL_BindBuffer;
+extern PFNGLBUFFERDATAPROC OpenGL_BufferData;
+extern PFNGLBUFFERSUBDATAPROC OpenGL_BufferSubData;
+extern PFNGLMAPBUFFERPROC OpenGL_MapBuffer;
+extern PFNGLUNMAPBUFFERPROC OpenGL_UnmapBuffer;
+
+#define glGenBuffers OpenGL_GenBuffers
+#define glDeleteBuffers OpenGL_DeleteBuffers
+#define glBindBuffer OpenGL_BindBuffer
+#define glBufferData OpenGL_BufferData
+#define glBufferSubData OpenGL_BufferSubData
+#define glMapBuffer OpenGL_MapBuffer
+#define glUnmapBuffer OpenGL_UnmapBuffer
+
+// OpenGL 2.0 shaders, optional
+
+extern PFNGLCREATESHADERPROC OpenGL_CreateShader;
+extern PFNGLDELETESHADERPROC OpenGL_DeleteShader;
+extern PFNGLSHADERSOURCEPROC OpenGL_ShaderSource;
+extern PFNGLCOMPILESHADERPROC OpenGL_CompileShader;
+extern PFNGLGETSHADERIVPROC OpenGL_GetShaderiv;
+extern PFNGLGETSHADERINFOLOGPROC OpenGL_GetShaderInfoLog;
+extern PFNGLCREATEPROGRAMPROC OpenGL_CreateProgram;
+extern PFNGLDELETEPROGRAMPROC OpenGL_DeleteProgram;
+extern PFNGLATTACHSHADERPROC OpenGL_AttachShader;
+extern PFNGLBINDATTRIBLOCATIONPROC OpenGL_BindAttribLocation;
+extern PFNGLLINKPROGRAMPROC OpenGL_LinkProgram;
+extern PFNGLGETPROGRAMIVPROC OpenGL_GetProgramiv;
+extern PFNGLGETPROGRAMINFOLOGPROC OpenGL_GetProgramInfoLog;
+extern PFNGLUSEPROGRAMPROC OpenGL_UseProgram;
+extern PFNGLGETUNIFORMLOCATIONPROC OpenGL_GetUniformLocation;
+extern PFNGLUNIFORM1IPROC OpenGL_Uniform1i;
+extern PFNGLUNIFORMMATRIX4FVPROC OpenGL_UniformMatrix4fv;
+extern PFNGLVERTEXATTRIB2FPROC OpenGL_VertexAttrib2f;
+extern PFNGLVERTEXATTRIB4FPROC OpenGL_VertexAttrib4f;
+extern PFNGLENABLEVERTEXATTRIBARRAYPROC OpenGL_EnableVertexAttribArray;
+extern PFNGLDISABLEVERTEXATTRIBARRAYPROC OpenGL_DisableVertexAttribArray;
+extern PFNGLVERTEXATTRIBPOINTERPROC OpenGL_VertexAttribPointer;
+
+#define glCreateShader OpenGL_CreateShader
+#define glDeleteShader OpenGL_DeleteShader
+#define glShaderSource OpenGL_ShaderSource
+#define glCompileShader OpenGL_CompileShader
+#define glGetShaderiv OpenGL_GetShaderiv
+#define glGetShaderInfoLog OpenGL_GetShaderInfoLog
+#define glCreateProgram OpenGL_CreateProgram
+#define glDeleteProgram OpenGL_DeleteProgram
+#define glAttachShader OpenGL_AttachShader
+#define glBindAttribLocation OpenGL_BindAttribLocation
+#define glLinkProgram OpenGL_LinkProgram
+#define glGetProgramiv OpenGL_GetProgramiv
+#define glGetProgramInfoLog OpenGL_GetProgramInfoLog
+#define glUseProgram OpenGL_UseProgram
+#define glGetUniformLocation OpenGL_GetUniformLocation
+#define glUniform1i OpenGL_Uniform1i
+#define glUniformMatrix4fv OpenGL_UniformMatrix4fv
+#define glVertexAttrib2f OpenGL_VertexAttrib2f
+#define glVertexAttrib4f OpenGL_VertexAttrib4f
+#define glEnableVertexAttribArray OpenGL_EnableVertexAttribArray
+#define glDisableVertexAttribArray OpenGL_DisableVertexAttribArray
+#define glVertexAttribPointer OpenGL_VertexAttribPointer
+
+// OpenGL 3.3 or ARB_draw_instanced + ARB_instanced_arrays, optional
+
+extern PFNGLDRAWARRAYSINSTANCEDPROC OpenGL_DrawArraysInstanced;
+extern PFNGLDRAWELEMENTSINSTANCEDPROC OpenGL_DrawElementsInstanced;
+extern PFNGLVERTEXATTRIBDIVISORPROC OpenGL_VertexAttribDivisor;
+
+#define glDrawArraysInstanced OpenGL_DrawArraysInstanced
+#define glDrawElementsInstanced OpenGL_DrawElementsInstanced
+#define glVertexAttribDivisor OpenGL_VertexAttribDivisor
+
+// OpenGL 3.0 or ARB_vertex_array_object, required by core profiles
+// (the ARB extension exports the core names)
+
+extern PFNGLGENVERTEXARRAYSPROC OpenGL_GenVertexArrays;
+extern PFNGLDELETEVERTEXARRAYSPROC OpenGL_DeleteVertexArrays;
+extern PFNGLBINDVERTEXARRAYPROC OpenGL_BindVertexArray;
+
+#define glGenVertexArrays OpenGL_GenVertexArrays
+#define glDeleteVertexArrays OpenGL_DeleteVertexArrays
+#define glBindVertexArray OpenGL_BindVertexArray
+
+// OpenGL 3.0 or ARB_framebuffer_object (framebuffers and mipmap generation),
+// optional
+
+extern PFNGLGENFRAMEBUFFERSPROC OpenGL_GenFramebuffers;
+extern PFNGLDELETEFRAMEBUFFERSPROC OpenGL_DeleteFramebuffers;
+extern PFNGLBINDFRAMEBUFFERPROC OpenGL_BindFramebuffer;
+extern PFNGLFRAMEBUFFERRENDERBUFFERPROC OpenGL_FramebufferRenderbuffer;
+extern PFNGLCHECKFRAMEBUFFERSTATUSPROC OpenGL_CheckFramebufferStatus;
+extern PFNGLGENRENDERBUFFERSPROC OpenGL_GenRenderbuffers;
+extern PFNGLDELETERENDERBUFFERSPROC OpenGL_DeleteRenderbuffers;
+extern PFNGLBINDRENDERBUFFERPROC OpenGL_BindRenderbuffer;
+extern PFNGLRENDERBUFFERSTORAGEPROC OpenGL_RenderbufferStorage;
+extern PFNGLGENERATEMIPMAPPROC OpenGL_GenerateMipmap;
+
+#define glGenFramebuffers OpenGL_GenFramebuffers
+#define glDeleteFramebuffers OpenGL_DeleteFramebuffers
+#define glBindFramebuffer OpenGL_BindFramebuffer
+#define glFramebufferRenderbuffer OpenGL_FramebufferRenderbuffer
+#define glCheckFramebufferStatus OpenGL_CheckFramebufferStatus
+#define glGenRenderbuffers OpenGL_GenRenderbuffers
+#define glDeleteRenderbuffers OpenGL_DeleteRenderbuffers
+#define glBindRenderbuffer OpenGL_BindRenderbuffer
+#define glRenderbufferStorage OpenGL_RenderbufferStorage
+#define glGenerateMipmap OpenGL_GenerateMipmap
+
+// OpenGL 3.2 or ARB_sync, optional
+
+extern PFNGLFENCESYNCPROC OpenGL_FenceSync;
+extern PFNGLCLIENTWAITSYNCPROC OpenGL_ClientWaitSync;
+extern PFNGLDELETESYNCPROC OpenGL_DeleteSync;
+
+#define glFenceSync OpenGL_FenceSync
+#define glClientWaitSync OpenGL_ClientWaitSync
+#define glDeleteSync OpenGL_DeleteSync
+
+extern int OpenGL_HasShaders;
+extern int OpenGL_HasInstancing;
+extern int OpenGL_HasVertexArrays;
+extern int OpenGL_HasFramebuffers;
+extern int OpenGL_HasPixelBuffers;
+extern int OpenGL_HasSync;
+
+// Resolves an entry point of the current context, e.g. SDL_GL_GetProcAddress.
+typedef void* (*OpenGL_Loader)(const char* name);
+
+int
+OpenGL_Init(OpenGL_Loader loader);
+
+char*
+OpenGL_GetError();
+
+#endif /* OPENGL_H */
@@ -0,0 +1,318 @@
+#include <math.h>
+#include <stdlib.h>
+
+#include "polyline.h"
+
+#define POLYLINE_PI 3.14159265358979323846f
+
+// Largest distance between round joins or caps and the true circle, in pixels.
+#define POLYLINE_TOLERANCE 0.25f
+
+void
+Polyline_Init(Polyline* polyline) {
+    polyline->vertices = NULL;
+    polyline->coverage = NULL;
+    polyline->length = 0;
+    polyline->capacity = 0;
+    polyline->failed = 0;
+    polyline->feather = 0.0f;
+    polyline->opacity = 255;
+}
+
+void
+Polyline_Free(Polyline* polyline) {
+    free(polyline->vertices);
+    free(polyline->coverage);
+    Polyline_Init(polyline);
+}
+
+// Appends a vertex, or remembers that memory ran out so that callers
+// only have to check once.
+static void
+Polyline_Vertex(Polyline* polyline, GLfloat x, GLfloat y, GLubyte coverage) {
+    if (polyline->failed) {
+        return;
+    }
+    if (polyline->length == polyline->capacity) {
+        int capacity = polyline->capacity ? polyline->capacity * 2 : 96;
+        GLfloat* vertices = (GLfloat*)realloc(polyline->vertices, capacity * 2 * sizeof(GLfloat));
+        GLubyte* values;
+        if (vertices == NULL) {
+            polyline->failed = 1;
+            return;
+        }
+        polyline->vertices = vertices;
+        values = (GLubyte*)realloc(polyline->coverage, capacity);
+        if (values == NULL) {
+            polyline->failed = 1;
+            return;
+        }
+        polyline->coverage = values;
+        polyline->capacity = capacity;
+    }
+    polyline->vertices[polyline->length * 2] = x;
+    polyline->vertices[polyline->length * 2 + 1] = y;
+    polyline->coverage[polyline->length] = coverage;
+    polyline->length++;
+}
+
+static void
+Polyline_Triangle(Polyline* polyline, GLfloat ax, GLfloat ay, GLfloat bx, GLfloat by, GLfloat cx, GLfloat cy) {
+    Polyline_Vertex(polyline, ax, ay, polyline->opacity);
+    Polyline_Vertex(polyline, bx, by, polyline->opacity);
+    Polyline_Vertex(polyline, cx, cy, polyline->opacity);
+}
+
+// Fades the edge from a to b out along the unit normal (nx, ny).
+static void
+Polyline_Feather(Polyline* polyline, GLfloat ax, GLfloat ay, GLfloat bx, GLfloat by, float nx, float ny) {
+    float fx = nx * polyline->feather;
+    float fy = ny * polyline->feather;
+    Polyline_Vertex(polyline, ax, ay, polyline->opacity);
+    Polyline_Vertex(polyline, bx, by, polyline->opacity);
+    Polyline_Vertex(polyline, ax + fx, ay + fy, 0);
+    Polyline_Vertex(polyline, bx, by, polyline->opacity);
+    Polyline_Vertex(polyline, bx + fx, by + fy, 0);
+    Polyline_Vertex(polyline, ax + fx, ay + fy, 0);
+}
+
+// Closes the feather around a corner between two edge normals.
+static void
+Polyline_Wedge(Polyline* polyline, GLfloat x, GLfloat y, float nx0, float ny0, float nx1, float ny1) {
+    float feather = polyline->feather;
+    Polyline_Vertex(polyline, x, y, polyline->opacity);
+    Polyline_Vertex(polyline, x + nx0 * feather, y + ny0 * feather, 0);
+    Polyline_Vertex(polyline, x + nx1 * feather, y + ny1 * feather, 0);
+}
+
+// Fans the rim points around (x, y), as joins and caps do. Rims run
+// counterclockwise for turn 1 and clockwise for turn -1, which tells the
+// outer side of their edges; the normals at both ends are those of the
+// edges they continue.
+static void
+Polyline_Fan(Polyline* polyline, GLfloat x, GLfloat y, const GLfloat* rim, int count, float turn, float nx0, float ny0, float nx1, float ny1) {
+    float previous_x = nx0, previous_y = ny0;
+    for (int i = 0; i + 1 < count; i++) {
+        Polyline_Triangle(polyline, x, y, rim[i * 2], rim[i * 2 + 1], rim[i * 2 + 2], rim[i * 2 + 3]);
+    }
+    if (polyline->feather == 0.0f) {
+        return;
+    }
+    for (int i = 0; i + 1 < count; i++) {
+        float ex = rim[i * 2 + 2] - rim[i * 2];
+        float ey = rim[i * 2 + 3] - rim[i * 2 + 1];
+        float length = sqrtf(ex * ex + ey * ey);
+        float nx, ny;
+        if (length < 1e-6f) {
+            continue;
+        }
+        nx = ey / length * turn;
+        ny = -ex / length * turn;
+        Polyline_Wedge(polyline, rim[i * 2], rim[i * 2 + 1], previous_x, previous_y, nx, ny);
+        Polyline_Feather(polyline, rim[i * 2], rim[i * 2 + 1], rim[i * 2 + 2], rim[i * 2 + 3], nx, ny);
+        previous_x = nx;
+        previous_y = ny;
+    }
+    Polyline_Wedge(polyline, rim[(count - 1) * 2], rim[(count - 1) * 2 + 1], previous_x, previous_y, nx1, ny1);
+}
+
+// Rim points of an arc around (x, y) from angle start, sweeping by sweep
+// radians; rim holds POLYLINE_MAX_ARC + 1 points.
+static int
+Polyline_Arc(GLfloat* rim, GLfloat x, GLfloat y, float radius, float start, float sweep) {
+    float step = radius > POLYLINE_TOLERANCE ? 2.0f * acosf(1.0f - POLYLINE_TOLERANCE / radius) : POLYLINE_PI / 2.0f;
+    int steps = (int)ceilf(fabsf(sweep) / step);
+    steps = steps < 1 ? 1 : (steps > POLYLINE_MAX_ARC ? POLYLINE_MAX_ARC : steps);
+    for (int i = 0; i <= steps; i++) {
+        float angle = start + sweep * i / steps;
+        rim[i * 2] = x + cosf(angle) * radius;
+        rim[i * 2 + 1] = y + sinf(angle) * radius;
+    }
+    return steps + 1;
+}
+
+static void
+Polyline_Direction(const GLfloat* from, const GLfloat* to, float* x, float* y) {
+    float dx = to[0] - from[0];
+    float dy = to[1] - from[1];
+    float length = sqrtf(dx * dx + dy * dy);
+    *x = dx / length;
+    *y = dy / length;
+}
+
+// Fills the gap on the outer side of the corner at point; the segment
+// quads already overlap on the inner side.
+static void
+Polyline_Join(Polyline* polyline, const GLfloat* previous, const GLfloat* point, const GLfloat* next, float half, int join) {
+    GLfloat rim[(POLYLINE_MAX_ARC + 1) * 2];
+    float x0, y0, x1, y1, cross, dot, side, nx0, ny0, nx1, ny1, turn;
+    int count = 0;
+    Polyline_Direction(previous, point, &x0, &y0);
+    Polyline_Direction(point, next, &x1, &y1);
+    cross = x0 * y1 - y0 * x1;
+    dot = x0 * x1 + y0 * y1;
+    if (fabsf(cross) < 1e-6f && dot > 0.0f) {
+        return;
+    }
+    side = cross > 0.0f ? -1.0f : 1.0f;
+    turn = -side;
+    nx0 = -y0 * side;
+    ny0 = x0 * side;
+    nx1 = -y1 * side;
+    ny1 = x1 * side;
+    if (join == POLYLINE_JOIN_ROUND) {
+        count = Polyline_Arc(rim, point[0], point[1], half, atan2f(ny0, nx0), atan2f(nx0 * ny1 - ny0 * nx1, nx0 * nx1 + ny0 * ny1));
+    }
+    else {
+        rim[count * 2] = point[0] + nx0 * half;
+        rim[count * 2 + 1] = point[1] + ny0 * half;
+        count++;
+        if (join == POLYLINE_JOIN_MITER) {
+            float mx = nx0 + nx1;
+            float my = ny0 + ny1;
+            float length = sqrtf(mx * mx + my * my);
+            // cosine of half the angle between both segments
+            float cosine = length > 1e-6f ? (mx * nx0 + my * ny0) / length : 0.0f;
+            if (cosine * POLYLINE_MITER_LIMIT >= 1.0f) {
+                rim[count * 2] = point[0] + mx / length * half / cosine;
+                rim[count * 2 + 1] = point[1] + my / length * half / cosine;
+                count++;
+            }
+        }
+        rim[count * 2] = point[0] + nx1 * half;
+        rim[count * 2 + 1] = point[1] + ny1 * half;
+        count++;
+    }
+    Polyline_Fan(polyline, point[0], point[1], rim, count, turn, nx0, ny0, nx1, ny1);
+}
+
+// Closes one end of an open line at (x, y) going in direction (ux, uy),
+// backwards at the start and forwards at the end.
+static void
+Polyline_Cap(Polyline* polyline, GLfloat x, GLfloat y, float ux, float uy, float half, int cap, int end) {
+    GLfloat rim[(POLYLINE_MAX_ARC + 1) * 2];
+    float nx = end ? uy : -uy;
+    float ny = end ? -ux : ux;
+    int count = 2;
+    // from the left side of the line to its right at the start, the other
+    // way around at the end, always counterclockwise
+    if (cap == POLYLINE_CAP_ROUND) {
+        count = Polyline_Arc(rim, x, y, half, atan2f(ny, nx), POLYLINE_PI);
+    }
+    else {
+        rim[0] = x + nx * half;
+        rim[1] = y + ny * half;
+        rim[2] = x - nx * half;
+        rim[3] = y - ny * half;
+    }
+    Polyline_Fan(polyline, x, y, rim, count, 1.0f, nx, ny, -nx, -ny);
+}
+
+// A single point only shows its caps.
+static void
+Polyline_Dot(Polyline* polyline, const GLfloat* point, float half, int cap) {
+    GLfloat rim[(POLYLINE_MAX_ARC + 1) * 2];
+    int count;
+    if (cap == POLYLINE_CAP_ROUND) {
+        count = Polyline_Arc(rim, point[0], point[1], half, 0.0f, 2.0f * POLYLINE_PI);
+        Polyline_Fan(polyline, point[0], point[1], rim, count, 1.0f, 1.0f, 0.0f, 1.0f, 0.0f);
+    }
+    else if (cap == POLYLINE_CAP_SQUARE) {
+        const float corners[] = {1.0f, -1.0f, 1.0f, 1.0f, -1.0f, 1.0f, -1.0f, -1.0f, 1.0f, -1.0f};
+        for (int i = 0; i < 5; i++) {
+            rim[i * 2] = point[0] + corners[i * 2] * half;
+            rim[i * 2 + 1] = point[1] + corners[i * 2 + 1] * half;
+        }
+        Polyline_Fan(polyline, point[0], point[1], rim, 5, 1.0f, 0.0f, -1.0f, 0.0f, -1.0f);
+    }
+}
+
+static void
+Polyline_ExtrudePoints(Polyline* polyline, const GLfloat* points, int count, int closed, float half, int join, int cap) {
+    int segments;
+    if (count == 1) {
+        Polyline_Dot(polyline, points, half, cap);
+        return;
+    }
+    if (count == 2 && closed) {
+        // a loop of two points is the segment drawn back and forth
+        closed = 0;
+        cap = POLYLINE_CAP_BUTT;
+    }
+    segments = closed ? count : count - 1;
+    for (int s = 0; s < segments; s++) {
+        const GLfloat* a = points + s * 2;
+        const GLfloat* b = points + (s + 1) % count * 2;
+        float ux, uy, ax, ay, bx, by, nx, ny;
+        Polyline_Direction(a, b, &ux, &uy);
+        ax = a[0];
+        ay = a[1];
+        bx = b[0];
+        by = b[1];
+        if (! closed && cap == POLYLINE_CAP_SQUARE) {
+            if (s == 0) {
+                ax -= ux * half;
+                ay -= uy * half;
+            }
+            if (s == segments - 1) {
+                bx += ux * half;
+                by += uy * half;
+            }
+        }
+        nx = -uy * half;
+        ny = ux * half;
+        Polyline_Triangle(polyline, ax + nx, ay + ny, ax - nx, ay - ny, bx + nx, by + ny);
+        Polyline_Triangle(polyline, bx + nx, by + ny, ax - nx, ay - ny, bx - nx, by - ny);
+        if (polyline->feather > 0.0f) {
+            Polyline_Feather(polyline, ax + nx, ay + ny, bx + nx, by + ny, -uy, ux);
+            Polyline_Feather(polyline, ax - nx, ay - ny, bx - nx, by - ny, uy, -ux);
+        }
+        if (! closed && s == 0) {
+            Polyline_Cap(polyline, ax, ay, ux, uy, half, cap, 0);
+        }
+        if (! closed && s == segments - 1) {
+            Polyline_Cap(polyline, bx, by, ux, uy, half, cap, 1);
+        }
+    }
+    for (int i = closed ? 0 : 1; i < (closed ? count : count - 1); i++) {
+        Polyline_Join(polyline, points + (i + count - 1) % count * 2, points + i * 2, points + (i + 1) % count * 2, half, join);
+    }
+}
+
+int
+Polyline_Extrude(Polyline* polyline, const GLfloat* points, int count, int closed, float width, int join, int cap, int smooth) {
+    GLfloat* unique;
+    float half = width * 0.5f;
+    int length = 0;
+    polyline->length = 0;
+    polyline->failed = 0;
+    polyline->feather = 0.0f;
+    polyline->opacity = 255;
+    if (count == 0 || width <= 0.0f) {
+        return 0;
+    }
+    if (smooth) {
+        // the edge is centered on the outline, lines thinner than it fade
+        polyline->feather = 1.0f;
+        half = half > 0.5f ? half - 0.5f : 0.0f;
+        polyline->opacity = width < 1.0f ? (GLubyte)(width * 255.0f + 0.5f) : 255;
+    }
+    // repeated points have no direction to extrude along
+    unique = (GLfloat*)malloc(count * 2 * sizeof(GLfloat));
+    if (unique == NULL) {
+        return -1;
+    }
+    for (int i = 0; i < count; i++) {
+        if (length == 0 || points[i * 2] != unique[length * 2 - 2] || points[i * 2 + 1] != unique[length * 2 - 1]) {
+            unique[length * 2] = points[i * 2];
+            unique[length * 2 + 1] = points[i * 2 + 1];
+            length++;
+        }
+    }
+    if (closed && length > 1 && unique[0] == unique[length * 2 - 2] && unique[1] == unique[length * 2 - 1]) {
+        length--;
+    }
+    Polyline_ExtrudePoints(polyline, unique, length, closed, half, join, cap);
+    free(unique);
+    return polyline->failed ? -1 : 0;
+}
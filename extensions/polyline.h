@@ -0,0 +1,51 @@
+#ifndef POLYLINE_H
+#define POLYLINE_H
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_opengl.h>
+
+#define POLYLINE_JOIN_MITER 0
+#define POLYLINE_JOIN_BEVEL 1
+#define POLYLINE_JOIN_ROUND 2
+
+#define POLYLINE_CAP_BUTT   0
+#define POLYLINE_CAP_SQUARE 1
+#define POLYLINE_CAP_ROUND  2
+
+// Miters longer than this many half widths are beveled instead.
+#define POLYLINE_MITER_LIMIT 4.0f
+
+// Most points on the rim of a round join or cap.
+#define POLYLINE_MAX_ARC 64
+
+// Triangles covering a thick line, as interleaved (x, y) points with the
+// coverage of each one. Buffers are kept between extrusions.
+typedef struct {
+    GLfloat* vertices;
+    GLubyte* coverage;
+    int length;
+    int capacity;
+    int failed;
+    // width of the anti-aliased edge and the coverage inside it
+    float feather;
+    GLubyte opacity;
+} Polyline;
+
+void
+Polyline_Init(Polyline* polyline);
+
+void
+Polyline_Free(Polyline* polyline);
+
+// Replaces the triangles with those of a line of the given width through
+// count points, closed into a loop or with caps at both ends. Smooth lines
+// get a one pixel edge fading to zero coverage, so they are anti-aliased
+// in a single pass. Returns -1 when out of memory.
+int
+Polyline_Extrude(Polyline* polyline, const GLfloat* points, int count, int closed, float width, int join, int cap, int smooth);
+
+#endif /* POLYLINE_H */
@@ -0,0 +1,169 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "queue.h"
+
+void
+RenderQueue_Init(RenderQueue* queue) {
+    memset(queue, 0, sizeof(RenderQueue));
+}
+
+void
+RenderQueue_Free(RenderQueue* queue) {
+    free(queue->items);
+    free(queue->vertices);
+    free(queue->keys);
+    free(queue->order);
+    RenderQueue_Init(queue);
+}
+
+Uint64
+RenderQueue_Key(int layer, int depth, const BatchState* state) {
+    // layer:8 depth:16 blend:2 texture:32 mode:6
+    return (Uint64)(layer & 0xff) << 56
+        | (Uint64)(depth & 0xffff) << 40
+        | (Uint64)(state->blend & 0x3) << 38
+        | (Uint64)state->texture << 6
+        | (Uint64)(state->mode & 0x3f);
+}
+
+BatchVertex*
+RenderQueue_Append(RenderQueue* queue, Uint64 key, const BatchState* state, int count) {
+    QueueItem* item;
+    if (queue->length == queue->capacity) {
+        int capacity = queue->capacity ? queue->capacity * 2 : 256;
+        QueueItem* items = (QueueItem*)realloc(queue->items, capacity * sizeof(QueueItem));
+        if (items == NULL) {
+            return NULL;
+        }
+        queue->items = items;
+        queue->capacity = capacity;
+    }
+    if (queue->vertex_length + count > queue->vertex_capacity) {
+        int capacity = queue->vertex_capacity ? queue->vertex_capacity : BATCH_INITIAL_CAPACITY;
+        BatchVertex* vertices;
+        while (capacity < queue->vertex_length + count) {
+            capacity *= 2;
+        }
+        vertices = (BatchVertex*)realloc(queue->vertices, capacity * sizeof(BatchVertex));
+        if (vertices == NULL) {
+            return NULL;
+        }
+        queue->vertices = vertices;
+        queue->vertex_capacity = capacity;
+    }
+    // consecutive draws with the same key and state stay one item
+    item = queue->length > 0 ? &queue->items[queue->length - 1] : NULL;
+    if (item == NULL || item->key != key || memcmp(&item->state, state, sizeof(BatchState)) != 0) {
+        item = &queue->items[queue->length++];
+        item->key = key;
+        item->state = *state;
+        item->first = queue->vertex_length;
+        item->count = 0;
+    }
+    item->count += count;
+    queue->vertex_length += count;
+    return queue->vertices + queue->vertex_length - count;
+}
+
+// Stable least significant digit radix sort of the item keys, a byte at a
+// time, skipping bytes that are the same in every key.
+static int
+RenderQueue_Sort(RenderQueue* queue) {
+    int length = queue->length;
+    int counts[8][256];
+    Uint64* keys;
+    Uint64* next_keys;
+    int* order;
+    int* next_order;
+    if (length > queue->scratch_capacity) {
+        Uint64* new_keys = (Uint64*)realloc(queue->keys, length * 2 * sizeof(Uint64));
+        int* new_order;
+        if (new_keys == NULL) {
+            return -1;
+        }
+        queue->keys = new_keys;
+        new_order = (int*)realloc(queue->order, length * 2 * sizeof(int));
+        if (new_order == NULL) {
+            return -1;
+        }
+        queue->order = new_order;
+        queue->scratch_capacity = length;
+    }
+    keys = queue->keys;
+    next_keys = keys + length;
+    order = queue->order;
+    next_order = order + length;
+    memset(counts, 0, sizeof(counts));
+    for (int i = 0; i < length; i++) {
+        Uint64 key = queue->items[i].key;
+        keys[i] = key;
+        order[i] = i;
+        for (int byte = 0; byte < 8; byte++) {
+            counts[byte][(key >> (byte * 8)) & 0xff]++;
+        }
+    }
+    for (int byte = 0; byte < 8; byte++) {
+        int* count = counts[byte];
+        int offset = 0;
+        Uint64* swap_keys;
+        int* swap_order;
+        if (count[(keys[0] >> (byte * 8)) & 0xff] == length) {
+            continue;
+        }
+        for (int digit = 0; digit < 256; digit++) {
+            int value = count[digit];
+            count[digit] = offset;
+            offset += value;
+        }
+        for (int i = 0; i < length; i++) {
+            int position = count[(keys[i] >> (byte * 8)) & 0xff]++;
+            next_keys[position] = keys[i];
+            next_order[position] = order[i];
+        }
+        swap_keys = keys;
+        keys = next_keys;
+        next_keys = swap_keys;
+        swap_order = order;
+        order = next_order;
+        next_order = swap_order;
+    }
+    // the sorted order may have ended up in either half
+    if (order != queue->order) {
+        memcpy(queue->order, order, length * sizeof(int));
+    }
+    return 0;
+}
+
+int
+RenderQueue_Flush(RenderQueue* queue, Batch* batch) {
+    // without memory to sort, draws still go out in submission order
+    int sorted = queue->length > 0 && RenderQueue_Sort(queue) == 0;
+    for (int i = 0; i < queue->length; i++) {
+        const QueueItem* item = &queue->items[sorted ? queue->order[i] : i];
+        BatchVertex* vertices = Batch_Append(batch, &item->state, item->count);
+        if (vertices == NULL) {
+            RenderQueue_Clear(queue);
+            return -1;
+        }
+        memcpy(vertices, queue->vertices + item->first, item->count * sizeof(BatchVertex));
+    }
+    RenderQueue_Clear(queue);
+    return 0;
+}
+
+void
+RenderQueue_Clear(RenderQueue* queue) {
+    queue->length = 0;
+    queue->vertex_length = 0;
+}
+
+int
+RenderQueue_UsesTexture(const RenderQueue* queue, GLuint texture) {
+    for (int i = 0; i < queue->length; i++) {
+        if (queue->items[i].state.texture == texture) {
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,67 @@
+#ifndef QUEUE_H
+#define QUEUE_H
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_opengl.h>
+
+#include "batch.h"
+
+#define QUEUE_MAX_LAYER 255
+#define QUEUE_MAX_DEPTH 65535
+
+// One submitted draw: its state and where its vertices are in the queue.
+typedef struct {
+    Uint64 key;
+    BatchState state;
+    int first;
+    int count;
+} QueueItem;
+
+// Draws held back until a flush, which replays them into a batch sorted
+// by key: layer, then depth, then blending, texture and primitive type,
+// so that draws on the same layer and depth group by state. Draws with
+// equal keys keep their order.
+typedef struct {
+    QueueItem* items;
+    int length;
+    int capacity;
+    BatchVertex* vertices;
+    int vertex_length;
+    int vertex_capacity;
+    // sort scratch, (key, item) pairs twice over
+    Uint64* keys;
+    int* order;
+    int scratch_capacity;
+} RenderQueue;
+
+void
+RenderQueue_Init(RenderQueue* queue);
+
+void
+RenderQueue_Free(RenderQueue* queue);
+
+Uint64
+RenderQueue_Key(int layer, int depth, const BatchState* state);
+
+// Returns room for count vertices of a draw, or NULL when out of memory.
+BatchVertex*
+RenderQueue_Append(RenderQueue* queue, Uint64 key, const BatchState* state, int count);
+
+// Appends every draw to the batch in key order and empties the queue.
+// Returns -1 when the batch ran out of memory, dropping the draws that
+// did not fit.
+int
+RenderQueue_Flush(RenderQueue* queue, Batch* batch);
+
+void
+RenderQueue_Clear(RenderQueue* queue);
+
+// Whether any queued draw samples the texture.
+int
+RenderQueue_UsesTexture(const RenderQueue* queue, GLuint texture);
+
+#endif /* QUEUE_H */
@@ -1,242 +1,2041 @@
+#include <math.h>
+
 #include "renderer.h"
+#include "coordinates.h"
+#include "font.h"
+#include "mesh.h"
+#include "opengl.h"
+#include "shader.h"
+#include "texture.h"
+
+#define INSTANCE_COMPONENTS 8
+
+static const char* instance_attributes[] = {"position", "transform", "color", NULL};
+
+static const char* instance_vertex_source =
+    "#version 120\n"
+    "attribute vec2 position;\n"
+    "attribute vec4 transform;\n"
+    "attribute vec4 color;\n"
+    "varying vec4 instance_color;\n"
+    "void main() {\n"
+    "    float angle = radians(transform.z);\n"
+    "    vec2 rotated = vec2(\n"
+    "        position.x * cos(angle) - position.y * sin(angle),\n"
+    "        position.x * sin(angle) + position.y * cos(angle));\n"
+    "    gl_Position = gl_ModelViewProjectionMatrix * vec4(rotated * transform.w + transform.xy, 0.0, 1.0);\n"
+    "    instance_color = color;\n"
+    "}\n";
+
+static const char* instance_fragment_source =
+    "#version 120\n"
+    "varying vec4 instance_color;\n"
+    "void main() {\n"
+    "    gl_FragColor = instance_color;\n"
+    "}\n";
+
+static const char* core_instance_vertex_source =
+    "#version 330 core\n"
+    "uniform mat4 projection;\n"
+    "uniform mat4 modelview;\n"
+    "in vec2 position;\n"
+    "in vec4 transform;\n"
+    "in vec4 color;\n"
+    "out vec4 instance_color;\n"
+    "void main() {\n"
+    "    float angle = radians(transform.z);\n"
+    "    vec2 rotated = vec2(\n"
+    "        position.x * cos(angle) - position.y * sin(angle),\n"
+    "        position.x * sin(angle) + position.y * cos(angle));\n"
+    "    gl_Position = projection * modelview * vec4(rotated * transform.w + transform.xy, 0.0, 1.0);\n"
+    "    instance_color = color;\n"
+    "}\n";
+
+static const char* core_instance_fragment_source =
+    "#version 330 core\n"
+    "in vec4 instance_color;\n"
+    "out vec4 fragment_color;\n"
+    "void main() {\n"
+    "    fragment_color = instance_color;\n"
+    "}\n";
+
+// Attribute order follows BATCH_ATTRIBUTE_*.
+static const char* core_attributes[] = {"position", "texture_coordinate", "color", NULL};
+
+// Replaces the fixed function pipeline: texture modulated by vertex color.
+static const char* core_vertex_source =
+    "#version 330 core\n"
+    "uniform mat4 projection;\n"
+    "uniform mat4 modelview;\n"
+    "in vec2 position;\n"
+    "in vec2 texture_coordinate;\n"
+    "in vec4 color;\n"
+    "out vec2 vertex_texture_coordinate;\n"
+    "out vec4 vertex_color;\n"
+    "void main() {\n"
+    "    gl_Position = projection * modelview * vec4(position, 0.0, 1.0);\n"
+    "    vertex_texture_coordinate = texture_coordinate;\n"
+    "    vertex_color = color;\n"
+    "}\n";
+
+static const char* core_fragment_source =
+    "#version 330 core\n"
+    "uniform sampler2D image;\n"
+    "in vec2 vertex_texture_coordinate;\n"
+    "in vec4 vertex_color;\n"
+    "out vec4 fragment_color;\n"
+    "void main() {\n"
+    "    fragment_color = texture(image, vertex_texture_coordinate) * vertex_color;\n"
+    "}\n";
+
+// Batched vertices are transformed on the CPU, everything drawn directly
+// from client arrays or buffers gets the current transform loaded instead.
+static void
+Renderer_LoadModelview(Renderer* self, int modelview) {
+    static const Transform identity = {1.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f};
+    GLfloat matrix[16];
+    if (self->modelview == modelview) {
+        return;
+    }
+    if (modelview == RENDERER_MODELVIEW_TRANSFORM) {
+        Transform_ToMatrix(TransformStack_Top(&self->transforms), matrix);
+    }
+    else {
+        Transform_ToMatrix(&identity, matrix);
+    }
+    if (self->backend == RENDERER_BACKEND_CORE) {
+        glUniformMatrix4fv(self->modelview_location, 1, GL_FALSE, matrix);
+    }
+    else {
+        glLoadMatrixf(matrix);
+    }
+    self->modelview = modelview;
+}
+
+static void
+Renderer_TransformChanged(Renderer* self) {
+    if (self->modelview == RENDERER_MODELVIEW_TRANSFORM) {
+        self->modelview = RENDERER_MODELVIEW_UNKNOWN;
+    }
+}
 
+// The core backend has no client arrays, so every draw goes through the
+// batch, which is flushed right away when batching is off. Recorded draws
+// always take the same path.
 static int
-Renderer_init(Renderer* self, PyObject* args, PyObject* kwargs) {
-    PyObject* target;
-    if (! PyArg_ParseTuple(args, "O", &target)) {
-        return NULL;
+Renderer_Batches(Renderer* self) {
+    return self->batching || self->backend == RENDERER_BACKEND_CORE || self->recording != NULL;
+}
+
+int
+Renderer_Flush(Renderer* self) {
+    int queued;
+    if (Renderer_MakeCurrent(self) != 0) {
+        return -1;
     }
-    if (! PyObject_IsInstance(target, (PyObject*)&WindowType)) {
-        PyErr_SetString(PyExc_TypeError, "Renderer window must be instance of wutu.graphics.Window");
+    queued = RenderQueue_Flush(&self->queue, &self->batch);
+    // what made it into the batch still goes out
+    if (self->batch.length > 0) {
+        Renderer_LoadModelview(self, RENDERER_MODELVIEW_IDENTITY);
+    }
+    Batch_Flush(&self->batch);
+    if (queued != 0) {
+        PyErr_NoMemory();
         return -1;
     }
-    self->window = (Window*)target;
-    Py_INCREF(self->window);
-    self->context = SDL_GL_CreateContext(self->window->instance);
-    if (self->context == NULL) {
+    return 0;
+}
+
+static int
+Renderer_FlushUnbatched(Renderer* self) {
+    if (! self->batching) {
+        return Renderer_Flush(self);
+    }
+    return 0;
+}
+
+// Sets what fixed function draws outside the batch depend on; only what
+// changed since the last draw reaches OpenGL.
+static void
+Renderer_ImmediateState(Renderer* self, GLuint texture, int client_arrays) {
+    GLState_Blend(&self->gl, self->blend);
+    GLState_BindTexture(&self->gl, texture);
+    GLState_ClientArrays(&self->gl, client_arrays);
+    GLState_Color(&self->gl, self->color);
+}
+
+static int
+Renderer_IsLineMode(GLenum mode) {
+    return mode == GL_LINES || mode == GL_LINE_LOOP || mode == GL_LINE_STRIP;
+}
+
+// Core profiles have no wide GL lines, so those are extruded instead.
+static int
+Renderer_ExtrudesLines(Renderer* self, GLenum mode, float width) {
+    return self->backend == RENDERER_BACKEND_CORE && Renderer_IsLineMode(mode) && width > 1.0f;
+}
+
+static void
+Renderer_BatchState(Renderer* self, BatchState* state, GLenum mode, GLuint texture) {
+    state->mode = mode;
+    state->texture = texture;
+    state->blend = self->blend;
+    state->line_width = 1.0f;
+    state->smooth = 0;
+}
+
+// Index of the source vertex behind output vertex k once a primitive is
+// split into separate points, lines or triangles.
+static int
+Renderer_PrimitiveIndex(GLenum mode, int k, int count) {
+    switch (mode) {
+        case GL_LINE_STRIP:
+            return k / 2 + k % 2;
+        case GL_LINE_LOOP:
+            return (k / 2 + k % 2) % count;
+        case GL_TRIANGLE_STRIP:
+            return k / 3 + k % 3;
+        case GL_TRIANGLE_FAN:
+            return k % 3 ? k / 3 + k % 3 : 0;
+        case GL_QUADS: {
+            static const int corners[] = {0, 1, 2, 0, 2, 3};
+            return k / 6 * 4 + corners[k % 6];
+        }
+        case GL_QUAD_STRIP: {
+            static const int corners[] = {0, 1, 3, 0, 3, 2};
+            return k / 6 * 2 + corners[k % 6];
+        }
+    }
+    return k;
+}
+
+// Applies the current transform to count points, in a scratch buffer
+// of the renderer, as everything in the batch is in screen space.
+static const GLfloat*
+Renderer_TransformPoints(Renderer* self, const GLfloat* data, int count) {
+    const Transform* transform = TransformStack_Top(&self->transforms);
+    if (! Transform_IsIdentity(transform)) {
+        if (count > self->transformed_capacity) {
+            GLfloat* transformed = (GLfloat*)realloc(self->transformed, count * 2 * sizeof(GLfloat));
+            if (transformed == NULL) {
+                PyErr_NoMemory();
+                return NULL;
+            }
+            self->transformed = transformed;
+            self->transformed_capacity = count;
+        }
+        Transform_Points(transform, data, self->transformed, count);
+        data = self->transformed;
+    }
+    Renderer_LoadModelview(self, RENDERER_MODELVIEW_IDENTITY);
+    return data;
+}
+
+// Keeps what owns a texture alive with the command list being recorded.
+static int
+Renderer_KeepTexture(Renderer* self, PyObject* owner) {
+    if (self->recording == NULL) {
+        return 0;
+    }
+    return CommandList_Keep(self->recording, owner);
+}
+
+// Room for count vertices in the batch, in the command list being
+// recorded, or in the render queue when draws are sorted.
+static BatchVertex*
+Renderer_Append(Renderer* self, const BatchState* state, int count) {
+    BatchVertex* vertices;
+    if (self->recording != NULL) {
+        vertices = RenderQueue_Append(&self->recording->commands, 0, state, count);
+    }
+    else if (self->sorting) {
+        vertices = RenderQueue_Append(&self->queue, RenderQueue_Key(self->layer, self->depth, state), state, count);
+    }
+    else {
+        vertices = Batch_Append(&self->batch, state, count);
+    }
+    if (vertices == NULL) {
+        PyErr_NoMemory();
+    }
+    return vertices;
+}
+
+// Appends the triangles of an indexed vertex list.
+static int
+Renderer_AppendTriangles(Renderer* self, BatchState* state, const GLfloat* data, const GLfloat* texture_data, int count, const GLuint* indices, int length, const GLubyte* color) {
+    BatchVertex* vertices;
+    int index;
+    data = Renderer_TransformPoints(self, data, count);
+    if (data == NULL) {
+        return -1;
+    }
+    state->mode = GL_TRIANGLES;
+    vertices = Renderer_Append(self, state, length);
+    if (vertices == NULL) {
+        return -1;
+    }
+    for (int k = 0; k < length; k++) {
+        index = indices[k] * 2;
+        vertices->x = data[index];
+        vertices->y = data[index + 1];
+        vertices->u = texture_data ? texture_data[index] : 0.0f;
+        vertices->v = texture_data ? texture_data[index + 1] : 0.0f;
+        vertices->r = color[0];
+        vertices->g = color[1];
+        vertices->b = color[2];
+        vertices->a = color[3];
+        vertices++;
+    }
+    return 0;
+}
+
+// Appends a polygon of any shape as triangles.
+static int
+Renderer_AppendPolygon(Renderer* self, BatchState* state, const GLfloat* data, const GLfloat* texture_data, int count, const GLubyte* color) {
+    int length;
+    const GLuint* indices = TriangulationCache_Get(&self->triangulations, data, count, &length);
+    if (indices == NULL) {
+        PyErr_NoMemory();
+        return -1;
+    }
+    return Renderer_AppendTriangles(self, state, data, texture_data, count, indices, length, color);
+}
+
+// Appends any primitive type as separate points, lines or triangles, so
+// that consecutive primitives can share one draw call.
+static int
+Renderer_AppendPrimitive(Renderer* self, BatchState* state, GLenum mode, const GLfloat* data, const GLfloat* texture_data, int count, const GLubyte* color) {
+    BatchVertex* vertices;
+    int length, index;
+    if (mode == GL_POLYGON) {
+        return Renderer_AppendPolygon(self, state, data, texture_data, count, color);
+    }
+    switch (mode) {
+        case GL_POINTS:
+            state->mode = GL_POINTS;
+            length = count;
+            break;
+        case GL_LINES:
+            state->mode = GL_LINES;
+            length = count / 2 * 2;
+            break;
+        case GL_LINE_STRIP:
+            state->mode = GL_LINES;
+            length = count > 1 ? (count - 1) * 2 : 0;
+            break;
+        case GL_LINE_LOOP:
+            state->mode = GL_LINES;
+            length = count > 1 ? count * 2 : 0;
+            break;
+        case GL_TRIANGLES:
+            state->mode = GL_TRIANGLES;
+            length = count / 3 * 3;
+            break;
+        case GL_TRIANGLE_STRIP:
+        case GL_TRIANGLE_FAN:
+            state->mode = GL_TRIANGLES;
+            length = count > 2 ? (count - 2) * 3 : 0;
+            break;
+        case GL_QUADS:
+            state->mode = GL_TRIANGLES;
+            length = count / 4 * 6;
+            break;
+        case GL_QUAD_STRIP:
+            state->mode = GL_TRIANGLES;
+            length = count > 3 ? (count - 2) / 2 * 6 : 0;
+            break;
+        default:
+            PyErr_SetString(PyExc_ValueError, "primitive mode can't be batched");
+            return -1;
+    }
+    data = Renderer_TransformPoints(self, data, count);
+    if (data == NULL) {
+        return -1;
+    }
+    vertices = Renderer_Append(self, state, length);
+    if (vertices == NULL) {
+        return -1;
+    }
+    for (int k = 0; k < length; k++) {
+        index = Renderer_PrimitiveIndex(mode, k, count) * 2;
+        vertices->x = data[index];
+        vertices->y = data[index + 1];
+        vertices->u = texture_data ? texture_data[index] : 0.0f;
+        vertices->v = texture_data ? texture_data[index + 1] : 0.0f;
+        vertices->r = color[0];
+        vertices->g = color[1];
+        vertices->b = color[2];
+        vertices->a = color[3];
+        vertices++;
+    }
+    return 0;
+}
+
+// Appends the extruded line, fading its color by the coverage of every vertex.
+static int
+Renderer_AppendPolyline(Renderer* self, Polyline* polyline, const GLubyte* color) {
+    BatchState state;
+    BatchVertex* vertices;
+    const GLfloat* data = Renderer_TransformPoints(self, polyline->vertices, polyline->length);
+    if (data == NULL) {
+        return -1;
+    }
+    Renderer_BatchState(self, &state, GL_TRIANGLES, 0);
+    vertices = Renderer_Append(self, &state, polyline->length);
+    if (vertices == NULL) {
+        return -1;
+    }
+    for (int i = 0; i < polyline->length; i++) {
+        vertices->x = data[i * 2];
+        vertices->y = data[i * 2 + 1];
+        vertices->u = 0.0f;
+        vertices->v = 0.0f;
+        vertices->r = color[0];
+        vertices->g = color[1];
+        vertices->b = color[2];
+        vertices->a = (GLubyte)((color[3] * polyline->coverage[i] + 127) / 255);
+        vertices++;
+    }
+    return 0;
+}
+
+// Appends lines, strips or loops as extruded triangles, for lines that
+// can't be drawn as GL lines: core profiles have no wide ones.
+static int
+Renderer_AppendLines(Renderer* self, GLenum mode, const GLfloat* data, int count, float width, int smoothing, const GLubyte* color) {
+    int step = mode == GL_LINES ? 2 : count;
+    for (int i = 0; i + 1 < count; i += step) {
+        if (Polyline_Extrude(&self->polyline, data + i * 2, SDL_min(step, count - i), mode == GL_LINE_LOOP, width, POLYLINE_JOIN_MITER, POLYLINE_CAP_BUTT, smoothing) != 0) {
+            PyErr_NoMemory();
+            return -1;
+        }
+        if (Renderer_AppendPolyline(self, &self->polyline, color) != 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static SDL_GLContext
+Renderer_CreateCoreContext(SDL_Window* window) {
+    SDL_GLContext context;
+    int major, minor, profile, flags;
+    SDL_GL_GetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, &major);
+    SDL_GL_GetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, &minor);
+    SDL_GL_GetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, &profile);
+    SDL_GL_GetAttribute(SDL_GL_CONTEXT_FLAGS, &flags);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
+#ifdef __APPLE__
+    // macOS only hands out forward compatible core contexts
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_FLAGS, flags | SDL_GL_CONTEXT_FORWARD_COMPATIBLE_FLAG);
+#endif
+    context = SDL_GL_CreateContext(window);
+    // leave the attributes as they were for other contexts
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, major);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, minor);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, profile);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_FLAGS, flags);
+    return context;
+}
+
+static int
+Renderer_InitCore(Renderer* self) {
+    GLfloat width = (GLfloat)self->width;
+    GLfloat height = (GLfloat)self->height;
+    if (! OpenGL_HasShaders || ! OpenGL_HasVertexArrays) {
+        PyErr_SetString(PyExc_RuntimeError, "OpenGL 3.3 core profile is not available");
+        return -1;
+    }
+    self->program = Shader_CreateProgram(core_vertex_source, core_fragment_source, core_attributes);
+    if (self->program == 0) {
+        PyErr_SetString(PyExc_RuntimeError, Shader_GetError());
+        return -1;
+    }
+    if (Batch_InitBuffers(&self->batch) != 0) {
+        PyErr_SetString(PyExc_RuntimeError, "OpenGL vertex arrays are not available");
+        return -1;
+    }
+    GLState_Invalidate(&self->gl);
+    glGenVertexArrays(1, &self->vertex_array);
+    // same as glOrtho(0, width, height, 0, -1, 1)
+    memset(self->projection, 0, sizeof(self->projection));
+    self->projection[0] = 2.0f / width;
+    self->projection[5] = -2.0f / height;
+    self->projection[10] = -1.0f;
+    self->projection[12] = -1.0f;
+    self->projection[13] = 1.0f;
+    self->projection[15] = 1.0f;
+    self->projection_location = glGetUniformLocation(self->program, "projection");
+    self->modelview_location = glGetUniformLocation(self->program, "modelview");
+    // the program stays bound for the lifetime of the context
+    GLState_UseProgram(&self->gl, self->program);
+    glUniformMatrix4fv(self->projection_location, 1, GL_FALSE, self->projection);
+    glUniform1i(glGetUniformLocation(self->program, "image"), 0);
+    self->modelview = RENDERER_MODELVIEW_UNKNOWN;
+    Renderer_LoadModelview(self, RENDERER_MODELVIEW_IDENTITY);
+    glDisable(GL_DEPTH_TEST);
+    GLState_Blend(&self->gl, self->blend);
+    glViewport(0, 0, self->width, self->height);
+    return 0;
+}
+
+// Renderer whose context was made current last.
+static Renderer* Renderer_Current = NULL;
+
+static int
+Renderer_MakeWindowCurrent(Renderer* self) {
+    if (SDL_GL_MakeCurrent(self->window->instance, self->context) != 0) {
         PyErr_SetString(PyExc_RuntimeError, SDL_GetError());
         return -1;
     }
+    return 0;
+}
+
+int
+Renderer_MakeCurrent(Renderer* self) {
+    if (Renderer_Current == self) {
+        return 0;
+    }
+    if (self->make_current(self) != 0) {
+        return -1;
+    }
+    Renderer_Current = self;
+    return 0;
+}
+
+Renderer*
+Renderer_GetCurrent(void) {
+    return Renderer_Current;
+}
+
+void
+Renderer_DeleteTexture(Renderer* self, GLuint texture) {
+    Renderer* previous = Renderer_Current;
+    if (Renderer_MakeCurrent(self) != 0) {
+        // the context is gone, and its textures with it
+        PyErr_Clear();
+        return;
+    }
+    // flushing the sort queue early splits the frame into separately
+    // sorted runs, so only do it when a queued draw needs the texture
+    if ((self->batch.state.texture == texture || RenderQueue_UsesTexture(&self->queue, texture)) && Renderer_Flush(self) != 0) {
+        // the queue is empty either way, nothing left refers to the texture
+        PyErr_WriteUnraisable((PyObject*)self);
+    }
+    glDeleteTextures(1, &texture);
+    GLState_DeleteTexture(&self->gl, texture);
+    if (previous != NULL && previous != self && Renderer_MakeCurrent(previous) != 0) {
+        PyErr_Clear();
+    }
+}
+
+int
+Renderer_InitState(Renderer* self, int width, int height, int backend) {
+    if (backend != RENDERER_BACKEND_LEGACY && backend != RENDERER_BACKEND_CORE) {
+        PyErr_SetString(PyExc_ValueError, "unknown renderer backend");
+        return -1;
+    }
+    self->width = width;
+    self->height = height;
+    GLState_Init(&self->gl);
+    Batch_Init(&self->batch, &self->gl);
+    Capture_Init(&self->capture);
+    if (TransformStack_Init(&self->transforms) != 0) {
+        PyErr_NoMemory();
+        return -1;
+    }
+    self->modelview = RENDERER_MODELVIEW_IDENTITY;
+    self->transformed = NULL;
+    self->transformed_capacity = 0;
+    TriangulationCache_Init(&self->triangulations);
+    Polyline_Init(&self->polyline);
+    CircleCache_Init(&self->circles);
+    RenderQueue_Init(&self->queue);
+    self->recording = NULL;
+    self->recording_depth = 0;
+    self->sorting = 0;
+    self->layer = 0;
+    self->depth = 0;
+    self->batching = 0;
+    self->blend = BATCH_BLEND_ALPHA;
+    self->vertex_format = COORDINATES_FLOAT32;
+    self->texture_format = COORDINATES_FLOAT32;
+    self->color[0] = self->color[1] = self->color[2] = self->color[3] = 255;
+    self->instance_program = 0;
+    self->instance_buffer = 0;
+    self->draw_calls = 0;
+    self->backend = backend;
+    self->program = 0;
+    self->vertex_array = 0;
+    self->make_current = Renderer_MakeWindowCurrent;
+    return 0;
+}
+
+int
+Renderer_InitPipeline(Renderer* self, OpenGL_Loader loader) {
+    if (OpenGL_Init(loader) != 0) {
+        PyErr_SetString(PyExc_RuntimeError, OpenGL_GetError());
+        return -1;
+    }
+    // creating a context makes it current
+    Renderer_Current = self;
+    GLState_Invalidate(&self->gl);
+    self->instancing = OpenGL_HasInstancing;
+    if (self->backend == RENDERER_BACKEND_CORE) {
+        return Renderer_InitCore(self);
+    }
     glDisable(GL_DEPTH_TEST);
     glShadeModel(GL_SMOOTH);
     glEnable(GL_TEXTURE_2D);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-    glEnable(GL_BLEND);
-    glViewport(0, 0, self->window->width, self->window->height);
+    GLState_Blend(&self->gl, self->blend);
+    glViewport(0, 0, self->width, self->height);
     glMatrixMode(GL_PROJECTION);
     glLoadIdentity();
-    glOrtho(0, self->window->width, self->window->height, 0, -1.0, 1.0);
+    glOrtho(0, self->width, self->height, 0, -1.0, 1.0);
     glMatrixMode(GL_MODELVIEW);
     glLoadIdentity();
     return 0;
 }
 
+static int
+Renderer_init(Renderer* self, PyObject* args, PyObject* kwargs) {
+    PyObject* target;
+    int backend = RENDERER_BACKEND_LEGACY;
+    if (! PyArg_ParseTuple(args, "O|i", &target, &backend)) {
+        return -1;
+    }
+    if (! PyObject_IsInstance(target, (PyObject*)&WindowType)) {
+        PyErr_SetString(PyExc_TypeError, "Renderer window must be instance of wutu.graphics.Window");
+        return -1;
+    }
+    self->window = (Window*)target;
+    Py_INCREF(self->window);
+    self->window->renderer = self;
+    if (Renderer_InitState(self, self->window->width, self->window->height, backend) != 0) {
+        return -1;
+    }
+    if (backend == RENDERER_BACKEND_CORE) {
+        self->context = Renderer_CreateCoreContext(self->window->instance);
+    }
+    else {
+        self->context = SDL_GL_CreateContext(self->window->instance);
+    }
+    if (self->context == NULL) {
+        PyErr_SetString(PyExc_RuntimeError, SDL_GetError());
+        return -1;
+    }
+    return Renderer_InitPipeline(self, (OpenGL_Loader)SDL_GL_GetProcAddress);
+}
+
 static void
 Renderer_dealloc(Renderer* self) {
-    Py_DECREF(self->window);
+    Renderer* previous = Renderer_Current;
+    if (self->window != NULL && self->window->renderer == self) {
+        self->window->renderer = NULL;
+    }
+    // the cycle collector may free renderers at any time, and the objects
+    // below only have names in their own context
+    if (self->make_current != NULL && Renderer_MakeCurrent(self) != 0) {
+        PyErr_Clear();
+    }
+    Batch_Free(&self->batch);
+    Capture_Free(&self->capture);
+    TransformStack_Free(&self->transforms);
+    TriangulationCache_Free(&self->triangulations);
+    Polyline_Free(&self->polyline);
+    CircleCache_Free(&self->circles);
+    RenderQueue_Free(&self->queue);
+    Py_CLEAR(self->recording);
+    free(self->transformed);
+    if (self->instance_program != 0) {
+        glDeleteProgram(self->instance_program);
+    }
+    if (self->instance_buffer != 0) {
+        glDeleteBuffers(1, &self->instance_buffer);
+    }
+    if (self->program != 0) {
+        glDeleteProgram(self->program);
+    }
+    if (self->vertex_array != 0) {
+        glDeleteVertexArrays(1, &self->vertex_array);
+    }
+    if (Renderer_Current == self) {
+        Renderer_Current = NULL;
+    }
+    if (previous != NULL && previous != self && Renderer_MakeCurrent(previous) != 0) {
+        PyErr_Clear();
+    }
+    Py_XDECREF(self->window);
     SDL_free(self->context);
     Py_TYPE(self)->tp_free((PyObject*)self);
 }
 
 static PyObject*
-Renderer_restore(Renderer* self) {
-    glPopMatrix();
+Renderer_restore(Renderer* self) {
+    // recordings start from their own transform
+    if ((self->recording != NULL && self->transforms.depth <= self->recording_depth) || TransformStack_Pop(&self->transforms) != 0) {
+        PyErr_SetString(PyExc_RuntimeError, "restore called without a matching save");
+        return NULL;
+    }
+    Renderer_TransformChanged(self);
+    Py_RETURN_NONE;
+}
+
+static PyObject*
+Renderer_rotate(Renderer* self, PyObject* args) {
+    float angle;
+    if (! PyArg_ParseTuple(args, "f", &angle))
+    {
+        return NULL;
+    }
+    Transform_Rotate(TransformStack_Top(&self->transforms), angle);
+    Renderer_TransformChanged(self);
+    Py_RETURN_NONE;
+}
+
+static PyObject*
+Renderer_save(Renderer* self) {
+    if (TransformStack_Push(&self->transforms) != 0) {
+        return PyErr_NoMemory();
+    }
+    Py_RETURN_NONE;
+}
+
+static PyObject*
+Renderer_translate(Renderer* self, PyObject* args) {
+    float x, y;
+    if (! PyArg_ParseTuple(args, "ff", &x, &y)) {
+        return NULL;
+    }
+    Transform_Translate(TransformStack_Top(&self->transforms), x, y);
+    Renderer_TransformChanged(self);
+    Py_RETURN_NONE;
+}
+
+static PyObject*
+Renderer__clear(Renderer* self, PyObject* args) {
+    float r, g, b, a;
+    if (! PyArg_ParseTuple(args, "ffff", &r, &g, &b, &a)) {
+        return NULL;
+    }
+    if (Renderer_MakeCurrent(self) != 0) {
+        return NULL;
+    }
+    // pending draws would be overwritten anyway
+    self->batch.length = 0;
+    RenderQueue_Clear(&self->queue);
+    glClearColor(r, g, b, a);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+    Transform_Identity(TransformStack_Top(&self->transforms));
+    Renderer_TransformChanged(self);
+    Py_RETURN_NONE;
+}
+
+static PyObject*
+Renderer_DrawLines(Renderer* self, PyObject* args, int closed) {
+    PyObject* object;
+    PyObject* smooth;
+    Coordinates coordinates;
+    float width;
+    int count, smoothing, join = -1, cap = -1;
+    if (! PyArg_ParseTuple(args, "OfO|ii", &object, &width, &smooth, &join, &cap)) {
+        return NULL;
+    }
+    if (Renderer_MakeCurrent(self) != 0) {
+        return NULL;
+    }
+    // -1 stands for the default of each
+    if (join < -1 || join > POLYLINE_JOIN_ROUND || cap < -1 || cap > POLYLINE_CAP_ROUND) {
+        PyErr_SetString(PyExc_ValueError, "unknown line join or cap");
+        return NULL;
+    }
+    if (Coordinates_FromObject(object, self->vertex_format, &coordinates) != 0) {
+        return NULL;
+    }
+    if (coordinates.length % 2 != 0) {
+        Coordinates_Release(&coordinates);
+        PyErr_SetString(PyExc_ValueError, "coordinates must be a sequence of float values (x0, y0, x1, y1 ...)");
+        return NULL;
+    }
+    count = (int)(coordinates.length / 2);
+    smoothing = smooth && PyBool_Check(smooth) && PyObject_IsTrue(smooth);
+
+    // wide lines are capped or slow as GL lines, and need joins; smooth
+    // ones get their own edges, GL_LINE_SMOOTH is unreliable and breaks
+    // batches
+    if (width > 1.0f || join >= 0 || cap >= 0 || smoothing) {
+        const GLfloat* data = Coordinates_AsFloats(&coordinates);
+        int result = -1;
+        if (data != NULL) {
+            if (Polyline_Extrude(&self->polyline, data, count, closed, width,
+                    join < 0 ? POLYLINE_JOIN_MITER : join, cap < 0 ? POLYLINE_CAP_BUTT : cap, smoothing) != 0) {
+                PyErr_NoMemory();
+            }
+            else {
+                result = Renderer_AppendPolyline(self, &self->polyline, self->color);
+            }
+        }
+        Coordinates_Release(&coordinates);
+        if (result != 0) {
+            return NULL;
+        }
+        if (Renderer_FlushUnbatched(self) != 0) {
+            return NULL;
+        }
+        Py_RETURN_NONE;
+    }
+
+    if (Renderer_Batches(self)) {
+        BatchState state;
+        const GLfloat* data = Coordinates_AsFloats(&coordinates);
+        int result = -1;
+        Renderer_BatchState(self, &state, GL_LINES, 0);
+        state.line_width = width;
+        state.smooth = smoothing;
+        // strips can't be concatenated, so every segment becomes a separate line
+        if (data != NULL) {
+            result = Renderer_AppendPrimitive(self, &state, closed ? GL_LINE_LOOP : GL_LINE_STRIP, data, NULL, count, self->color);
+        }
+        Coordinates_Release(&coordinates);
+        if (result != 0) {
+            return NULL;
+        }
+        if (Renderer_FlushUnbatched(self) != 0) {
+            return NULL;
+        }
+        Py_RETURN_NONE;
+    }
+
+    Renderer_LoadModelview(self, RENDERER_MODELVIEW_TRANSFORM);
+    Renderer_ImmediateState(self, 0, GLSTATE_VERTEX_ARRAY);
+    GLState_LineWidth(&self->gl, width);
+    GLState_LineSmooth(&self->gl, smoothing);
+    glVertexPointer(2, coordinates.type, 0, coordinates.data);
+    glDrawArrays(closed ? GL_LINE_LOOP : GL_LINE_STRIP, 0, count);
+    self->draw_calls++;
+    Coordinates_Release(&coordinates);
+    Py_RETURN_NONE;
+}
+
+static PyObject*
+Renderer__draw_line_loop(Renderer* self, PyObject* args) {
+    return Renderer_DrawLines(self, args, 1);
+}
+
+static PyObject*
+Renderer__draw_line_strip(Renderer* self, PyObject* args) {
+    return Renderer_DrawLines(self, args, 0);
+}
+
+// Appends a convex shape, filled or outlined. Outlines are always
+// extruded, so that fills and outlines of any width share a draw call.
+static int
+Renderer_AppendShape(Renderer* self, const GLfloat* points, int count, int fill, float width, int smoothing, int join) {
+    BatchState state;
+    if (fill) {
+        Renderer_BatchState(self, &state, GL_TRIANGLES, 0);
+        return Renderer_AppendPrimitive(self, &state, GL_TRIANGLE_FAN, points, NULL, count, self->color);
+    }
+    if (Polyline_Extrude(&self->polyline, points, count, 1, width, join < 0 ? POLYLINE_JOIN_MITER : join, POLYLINE_CAP_BUTT, smoothing) != 0) {
+        PyErr_NoMemory();
+        return -1;
+    }
+    return Renderer_AppendPolyline(self, &self->polyline, self->color);
+}
+
+// Packed (x, y, ...) records of a bulk draw, as floats.
+static const GLfloat*
+Renderer_Records(PyObject* object, Coordinates* coordinates, int size, int* count) {
+    const GLfloat* data;
+    if (Coordinates_FromObject(object, COORDINATES_FLOAT32, coordinates) != 0) {
+        return NULL;
+    }
+    if (coordinates->length % size != 0) {
+        Coordinates_Release(coordinates);
+        PyErr_Format(PyExc_ValueError, "values must come in groups of %d", size);
+        return NULL;
+    }
+    data = Coordinates_AsFloats(coordinates);
+    if (data == NULL) {
+        Coordinates_Release(coordinates);
+        return NULL;
+    }
+    *count = (int)(coordinates->length / size);
+    return data;
+}
+
+static PyObject*
+Renderer__draw_rectangles(Renderer* self, PyObject* args) {
+    PyObject* object;
+    Coordinates coordinates;
+    const GLfloat* data;
+    float width;
+    int count, fill, smoothing;
+    if (! PyArg_ParseTuple(args, "Opfp", &object, &fill, &width, &smoothing)) {
+        return NULL;
+    }
+    if (Renderer_MakeCurrent(self) != 0) {
+        return NULL;
+    }
+    data = Renderer_Records(object, &coordinates, 4, &count);
+    if (data == NULL) {
+        return NULL;
+    }
+    for (int i = 0; i < count; i++) {
+        GLfloat x = data[i * 4], y = data[i * 4 + 1], w = data[i * 4 + 2], h = data[i * 4 + 3];
+        GLfloat points[8];
+        points[0] = x;
+        points[1] = y;
+        points[2] = x;
+        points[3] = y + h;
+        points[4] = x + w;
+        points[5] = y + h;
+        points[6] = x + w;
+        points[7] = y;
+        if (Renderer_AppendShape(self, points, 4, fill, width, smoothing, -1) != 0) {
+            Coordinates_Release(&coordinates);
+            return NULL;
+        }
+    }
+    Coordinates_Release(&coordinates);
+    if (Renderer_FlushUnbatched(self) != 0) {
+        return NULL;
+    }
+    Py_RETURN_NONE;
+}
+
+static PyObject*
+Renderer__draw_circles(Renderer* self, PyObject* args) {
+    PyObject* object;
+    Coordinates coordinates;
+    const GLfloat* data;
+    GLfloat points[CIRCLES_MAX_SEGMENTS * 2];
+    float width;
+    int count, fill, smoothing, segments;
+    if (! PyArg_ParseTuple(args, "Opfpi", &object, &fill, &width, &smoothing, &segments)) {
+        return NULL;
+    }
+    if (Renderer_MakeCurrent(self) != 0) {
+        return NULL;
+    }
+    if (segments != 0 && (segments < CIRCLES_MIN_SEGMENTS || segments > CIRCLES_MAX_SEGMENTS)) {
+        PyErr_Format(PyExc_ValueError, "circles must have between %d and %d segments", CIRCLES_MIN_SEGMENTS, CIRCLES_MAX_SEGMENTS);
+        return NULL;
+    }
+    data = Renderer_Records(object, &coordinates, 3, &count);
+    if (data == NULL) {
+        return NULL;
+    }
+    for (int i = 0; i < count; i++) {
+        GLfloat x = data[i * 3], y = data[i * 3 + 1], radius = data[i * 3 + 2];
+        int length;
+        const GLfloat* table;
+        if (! isfinite(radius)) {
+            Coordinates_Release(&coordinates);
+            PyErr_SetString(PyExc_ValueError, "circle radius must be finite");
+            return NULL;
+        }
+        length = segments ? segments : Circles_Segments(radius);
+        table = CircleCache_Get(&self->circles, length);
+        if (table == NULL) {
+            Coordinates_Release(&coordinates);
+            return PyErr_NoMemory();
+        }
+        for (int k = 0; k < length; k++) {
+            points[k * 2] = x + table[k * 2] * radius;
+            points[k * 2 + 1] = y + table[k * 2 + 1] * radius;
+        }
+        if (Renderer_AppendShape(self, points, length, fill, width, smoothing, -1) != 0) {
+            Coordinates_Release(&coordinates);
+            return NULL;
+        }
+    }
+    Coordinates_Release(&coordinates);
+    if (Renderer_FlushUnbatched(self) != 0) {
+        return NULL;
+    }
+    Py_RETURN_NONE;
+}
+
+static PyObject*
+Renderer__draw_line_loops(Renderer* self, PyObject* args) {
+    PyObject* object;
+    PyObject* offsets_object;
+    Coordinates coordinates;
+    Coordinates offsets;
+    const GLfloat* data;
+    const GLint* starts;
+    float width;
+    int count, loops, smoothing, join;
+    if (! PyArg_ParseTuple(args, "OOfpi", &object, &offsets_object, &width, &smoothing, &join)) {
+        return NULL;
+    }
+    if (Renderer_MakeCurrent(self) != 0) {
+        return NULL;
+    }
+    if (join < -1 || join > POLYLINE_JOIN_ROUND) {
+        PyErr_SetString(PyExc_ValueError, "unknown line join");
+        return NULL;
+    }
+    data = Renderer_Records(object, &coordinates, 2, &count);
+    if (data == NULL) {
+        return NULL;
+    }
+    if (Coordinates_FromObject(offsets_object, COORDINATES_INT32, &offsets) != 0) {
+        Coordinates_Release(&coordinates);
+        return NULL;
+    }
+    starts = Coordinates_AsInts(&offsets);
+    if (starts == NULL) {
+        Coordinates_Release(&offsets);
+        Coordinates_Release(&coordinates);
+        return NULL;
+    }
+    loops = (int)offsets.length;
+    for (int i = 0; i < loops; i++) {
+        int start = starts[i];
+        int end = i + 1 < loops ? starts[i + 1] : count;
+        if (start < 0 || end < start || end > count) {
+            Coordinates_Release(&offsets);
+            Coordinates_Release(&coordinates);
+            PyErr_SetString(PyExc_ValueError, "offsets must be increasing point indices");
+            return NULL;
+        }
+        if (end - start < 2) {
+            continue;
+        }
+        // loops are outlines only, never filled
+        if (Renderer_AppendShape(self, data + start * 2, end - start, 0, width, smoothing, join) != 0) {
+            Coordinates_Release(&offsets);
+            Coordinates_Release(&coordinates);
+            return NULL;
+        }
+    }
+    Coordinates_Release(&offsets);
+    Coordinates_Release(&coordinates);
+    if (Renderer_FlushUnbatched(self) != 0) {
+        return NULL;
+    }
+    Py_RETURN_NONE;
+}
+
+// Draws a polygon of any shape from the enabled client arrays.
+static int
+Renderer_DrawPolygonElements(Renderer* self, Coordinates* coordinates, int count) {
+    const GLfloat* data = Coordinates_AsFloats(coordinates);
+    const GLuint* indices;
+    int length;
+    if (data == NULL) {
+        return -1;
+    }
+    indices = TriangulationCache_Get(&self->triangulations, data, count, &length);
+    if (indices == NULL) {
+        PyErr_NoMemory();
+        return -1;
+    }
+    glDrawElements(GL_TRIANGLES, length, GL_UNSIGNED_INT, indices);
+    return 0;
+}
+
+static PyObject*
+Renderer__draw_polygon(Renderer* self, PyObject* args) {
+    PyObject* object;
+    Coordinates coordinates;
+    int count;
+    if (! PyArg_ParseTuple(args, "O", &object)) {
+        return NULL;
+    }
+    if (Renderer_MakeCurrent(self) != 0) {
+        return NULL;
+    }
+    if (Coordinates_FromObject(object, self->vertex_format, &coordinates) != 0) {
+        return NULL;
+    }
+    if (coordinates.length % 2 != 0) {
+        Coordinates_Release(&coordinates);
+        PyErr_SetString(PyExc_ValueError, "coordinates must be a sequence of float values (x0, y0, x1, y1 ...)");
+        return NULL;
+    }
+    count = (int)(coordinates.length / 2);
+
+    if (Renderer_Batches(self)) {
+        BatchState state;
+        const GLfloat* data = Coordinates_AsFloats(&coordinates);
+        int result = -1;
+        Renderer_BatchState(self, &state, GL_TRIANGLES, 0);
+        if (data != NULL) {
+            result = Renderer_AppendPrimitive(self, &state, GL_POLYGON, data, NULL, count, self->color);
+        }
+        Coordinates_Release(&coordinates);
+        if (result != 0) {
+            return NULL;
+        }
+        if (Renderer_FlushUnbatched(self) != 0) {
+            return NULL;
+        }
+        Py_RETURN_NONE;
+    }
+
+    Renderer_LoadModelview(self, RENDERER_MODELVIEW_TRANSFORM);
+    Renderer_ImmediateState(self, 0, GLSTATE_VERTEX_ARRAY);
+    glVertexPointer(2, coordinates.type, 0, coordinates.data);
+    if (Renderer_DrawPolygonElements(self, &coordinates, count) != 0) {
+        Coordinates_Release(&coordinates);
+        return NULL;
+    }
+    self->draw_calls++;
+    Coordinates_Release(&coordinates);
+    Py_RETURN_NONE;
+}
+
+static PyObject*
+Renderer__draw_textured_polygon(Renderer* self, PyObject* args) {
+    PyObject* object;
+    PyObject* texture_object;
+    Coordinates coordinates;
+    Coordinates texture_coordinates;
+    Texture* owner;
+    GLuint texture;
+    int count, result;
+    if (! PyArg_ParseTuple(args, "OOO!", &object, &texture_object, &TextureType, &owner)) {
+        return NULL;
+    }
+    if (Renderer_MakeCurrent(self) != 0) {
+        return NULL;
+    }
+    if (Renderer_KeepTexture(self, (PyObject*)owner) != 0) {
+        return NULL;
+    }
+    texture = owner->id;
+    if (Coordinates_FromObject(object, self->vertex_format, &coordinates) != 0) {
+        return NULL;
+    }
+    if (Coordinates_FromObject(texture_object, self->texture_format, &texture_coordinates) != 0) {
+        Coordinates_Release(&coordinates);
+        return NULL;
+    }
+    if (coordinates.length % 2 != 0 || texture_coordinates.length != coordinates.length) {
+        Coordinates_Release(&coordinates);
+        Coordinates_Release(&texture_coordinates);
+        PyErr_SetString(PyExc_ValueError, "texture coordinates must be given for every vertex (u0, v0, u1, v1 ...)");
+        return NULL;
+    }
+    count = (int)(coordinates.length / 2);
+
+    if (Renderer_Batches(self)) {
+        BatchState state;
+        const GLfloat* data = Coordinates_AsFloats(&coordinates);
+        const GLfloat* texture_data = Coordinates_AsFloats(&texture_coordinates);
+        result = -1;
+        if (data != NULL && texture_data != NULL) {
+            Renderer_BatchState(self, &state, GL_TRIANGLES, texture);
+            result = Renderer_AppendPrimitive(self, &state, GL_POLYGON, data, texture_data, count, self->color);
+        }
+        Coordinates_Release(&coordinates);
+        Coordinates_Release(&texture_coordinates);
+        if (result != 0) {
+            return NULL;
+        }
+        if (Renderer_FlushUnbatched(self) != 0) {
+            return NULL;
+        }
+        Py_RETURN_NONE;
+    }
+
+    Renderer_LoadModelview(self, RENDERER_MODELVIEW_TRANSFORM);
+    Renderer_ImmediateState(self, texture, GLSTATE_VERTEX_ARRAY | GLSTATE_TEXTURE_COORD_ARRAY);
+    glVertexPointer(2, coordinates.type, 0, coordinates.data);
+    if (texture_coordinates.normalized) {
+        // fixed function texture coordinates are neither unsigned nor
+        // normalized, and floats hold every 16 bit value exactly
+        const GLfloat* texture_data = Coordinates_AsFloats(&texture_coordinates);
+        if (texture_data == NULL) {
+            Coordinates_Release(&coordinates);
+            Coordinates_Release(&texture_coordinates);
+            return NULL;
+        }
+        glTexCoordPointer(2, GL_FLOAT, 0, texture_data);
+    }
+    else {
+        glTexCoordPointer(2, texture_coordinates.type, 0, texture_coordinates.data);
+    }
+    result = Renderer_DrawPolygonElements(self, &coordinates, count);
+    Coordinates_Release(&coordinates);
+    Coordinates_Release(&texture_coordinates);
+    if (result != 0) {
+        return NULL;
+    }
+    self->draw_calls++;
+    Py_RETURN_NONE;
+}
+
+// Core profile mesh draws: constant attributes stand in for the color and
+// texture coordinate arrays.
+static void
+Renderer_BindMesh(Renderer* self, Mesh* mesh) {
+    glBindVertexArray(self->vertex_array);
+    glBindBuffer(GL_ARRAY_BUFFER, mesh->buffer);
+    glEnableVertexAttribArray(BATCH_ATTRIBUTE_POSITION);
+    glVertexAttribPointer(BATCH_ATTRIBUTE_POSITION, 2, mesh->type, GL_FALSE, 0, (const GLvoid*)0);
+    glVertexAttrib2f(BATCH_ATTRIBUTE_TEXTURE_COORDINATE, 0.0f, 0.0f);
+    glVertexAttrib4f(BATCH_ATTRIBUTE_COLOR,
+        self->color[0] / 255.0f, self->color[1] / 255.0f,
+        self->color[2] / 255.0f, self->color[3] / 255.0f);
+    GLState_BindTexture(&self->gl, self->batch.blank_texture);
+}
+
+// Draws the bound mesh buffer, filled polygons through their triangulation.
+static void
+Renderer_DrawMeshArrays(Mesh* mesh, GLenum mode) {
+    if (mode == GL_POLYGON) {
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->index_buffer);
+        glDrawElements(GL_TRIANGLES, mesh->index_count, GL_UNSIGNED_INT, (const GLvoid*)0);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+        return;
+    }
+    glDrawArrays(mode, 0, mesh->length);
+}
+
+static PyObject*
+Renderer__draw_mesh(Renderer* self, PyObject* args) {
+    Mesh* mesh;
+    PyObject* smooth;
+    GLenum mode;
+    float width;
+    int smoothing;
+    if (! PyArg_ParseTuple(args, "O!IfO", &MeshType, &mesh, &mode, &width, &smooth)) {
+        return NULL;
+    }
+    if (Renderer_MakeCurrent(self) != 0) {
+        return NULL;
+    }
+    if (mesh->renderer != self) {
+        PyErr_SetString(PyExc_ValueError, "mesh was created by another renderer");
+        return NULL;
+    }
+    if (mode > GL_POLYGON) {
+        PyErr_SetString(PyExc_ValueError, "unknown primitive mode");
+        return NULL;
+    }
+
+    if (mode == GL_POLYGON && Mesh_Triangulate(mesh) != 0) {
+        return NULL;
+    }
+
+    // smooth outlines, and wide lines of core profiles, are extruded from
+    // the copy kept on the CPU, which batches them with everything else
+    smoothing = smooth && PyBool_Check(smooth) && PyObject_IsTrue(smooth);
+    if ((smoothing && (mode == GL_LINE_LOOP || mode == GL_LINE_STRIP)) ||
+        Renderer_ExtrudesLines(self, mode, width)) {
+        if (Renderer_AppendLines(self, mode, mesh->vertices, mesh->length, width, smoothing, self->color) != 0) {
+            return NULL;
+        }
+        if (Renderer_FlushUnbatched(self) != 0) {
+            return NULL;
+        }
+        Py_RETURN_NONE;
+    }
+
+    // recordings keep their own copy of the vertices, not the buffer, and
+    // core profiles have no quads
+    if (self->recording != NULL || (self->backend == RENDERER_BACKEND_CORE && (mode == GL_QUADS || mode == GL_QUAD_STRIP))) {
+        BatchState state;
+        int result;
+        Renderer_BatchState(self, &state, GL_TRIANGLES, 0);
+        state.line_width = width;
+        if (mode == GL_POLYGON) {
+            result = Renderer_AppendTriangles(self, &state, mesh->vertices, NULL, mesh->length, mesh->indices, mesh->index_count, self->color);
+        }
+        else {
+            result = Renderer_AppendPrimitive(self, &state, mode, mesh->vertices, NULL, mesh->length, self->color);
+        }
+        if (result != 0) {
+            return NULL;
+        }
+        if (Renderer_FlushUnbatched(self) != 0) {
+            return NULL;
+        }
+        Py_RETURN_NONE;
+    }
+
+    // the buffer is drawn as is, so everything collected before has to go first
+    if (Renderer_Flush(self) != 0) {
+        return NULL;
+    }
+    Renderer_LoadModelview(self, RENDERER_MODELVIEW_TRANSFORM);
+    if (Renderer_IsLineMode(mode)) {
+        GLState_LineWidth(&self->gl, width);
+        GLState_LineSmooth(&self->gl, smoothing);
+    }
+    if (self->backend == RENDERER_BACKEND_CORE) {
+        GLState_Blend(&self->gl, self->blend);
+        Renderer_BindMesh(self, mesh);
+        Renderer_DrawMeshArrays(mesh, mode);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        glBindVertexArray(0);
+        self->draw_calls++;
+        Py_RETURN_NONE;
+    }
+    Renderer_ImmediateState(self, 0, GLSTATE_VERTEX_ARRAY);
+    glBindBuffer(GL_ARRAY_BUFFER, mesh->buffer);
+    glVertexPointer(2, mesh->type, 0, (const GLvoid*)0);
+    Renderer_DrawMeshArrays(mesh, mode);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    self->draw_calls++;
+    Py_RETURN_NONE;
+}
+
+// Expands every instance on the CPU into the batch, for contexts without
+// instanced arrays.
+static int
+Renderer_AppendInstances(Renderer* self, Mesh* mesh, const GLfloat* instances, int count, GLenum mode, float width, int smoothing) {
+    BatchState state;
+    GLfloat* vertices;
+    GLubyte color[4];
+    int result = 0;
+    vertices = (GLfloat*)malloc((mesh->length ? mesh->length : 1) * 2 * sizeof(GLfloat));
+    if (vertices == NULL) {
+        PyErr_NoMemory();
+        return -1;
+    }
+    Renderer_BatchState(self, &state, mode, 0);
+    state.line_width = width;
+    state.smooth = smoothing;
+    for (int i = 0; i < count && result == 0; i++) {
+        const GLfloat* instance = instances + i * INSTANCE_COMPONENTS;
+        float angle = instance[2] * (float)Py_MATH_PI / 180.0f;
+        float c = cosf(angle) * instance[3];
+        float s = sinf(angle) * instance[3];
+        for (int v = 0; v < mesh->length; v++) {
+            GLfloat x = mesh->vertices[v * 2];
+            GLfloat y = mesh->vertices[v * 2 + 1];
+            vertices[v * 2] = x * c - y * s + instance[0];
+            vertices[v * 2 + 1] = x * s + y * c + instance[1];
+        }
+        for (int k = 0; k < 4; k++) {
+            float value = instance[4 + k] < 0.0f ? 0.0f : (instance[4 + k] > 1.0f ? 1.0f : instance[4 + k]);
+            color[k] = (GLubyte)(value * 255.0f + 0.5f);
+        }
+        if (mode == GL_POLYGON) {
+            result = Renderer_AppendTriangles(self, &state, vertices, NULL, mesh->length, mesh->indices, mesh->index_count, color);
+        }
+        else if (Renderer_ExtrudesLines(self, mode, width)) {
+            result = Renderer_AppendLines(self, mode, vertices, mesh->length, width, smoothing, color);
+        }
+        else {
+            result = Renderer_AppendPrimitive(self, &state, mode, vertices, NULL, mesh->length, color);
+        }
+    }
+    free(vertices);
+    if (result == 0) {
+        result = Renderer_FlushUnbatched(self);
+    }
+    return result;
+}
+
+static PyObject*
+Renderer__draw_instances(Renderer* self, PyObject* args) {
+    Mesh* mesh;
+    PyObject* object;
+    PyObject* smooth;
+    Coordinates instances;
+    const GLfloat* data;
+    GLenum mode;
+    float width;
+    int count, smoothing;
+    if (! PyArg_ParseTuple(args, "O!OIfO", &MeshType, &mesh, &object, &mode, &width, &smooth)) {
+        return NULL;
+    }
+    if (Renderer_MakeCurrent(self) != 0) {
+        return NULL;
+    }
+    if (mesh->renderer != self) {
+        PyErr_SetString(PyExc_ValueError, "mesh was created by another renderer");
+        return NULL;
+    }
+    if (mode > GL_POLYGON) {
+        PyErr_SetString(PyExc_ValueError, "unknown primitive mode");
+        return NULL;
+    }
+    if (Coordinates_FromObject(object, COORDINATES_FLOAT32, &instances) != 0) {
+        return NULL;
+    }
+    if (instances.length % INSTANCE_COMPONENTS != 0) {
+        Coordinates_Release(&instances);
+        PyErr_SetString(PyExc_ValueError, "transforms must be a sequence of (x, y, angle, scale, r, g, b, a) values");
+        return NULL;
+    }
+    data = Coordinates_AsFloats(&instances);
+    if (data == NULL) {
+        Coordinates_Release(&instances);
+        return NULL;
+    }
+    count = (int)(instances.length / INSTANCE_COMPONENTS);
+    smoothing = smooth && PyBool_Check(smooth) && PyObject_IsTrue(smooth);
+    if (mode == GL_POLYGON && Mesh_Triangulate(mesh) != 0) {
+        Coordinates_Release(&instances);
+        return NULL;
+    }
+
+    if (self->instancing && self->instance_program == 0) {
+        if (self->backend == RENDERER_BACKEND_CORE) {
+            self->instance_program = Shader_CreateProgram(core_instance_vertex_source, core_instance_fragment_source, instance_attributes);
+        }
+        else {
+            self->instance_program = Shader_CreateProgram(instance_vertex_source, instance_fragment_source, instance_attributes);
+        }
+        if (self->instance_program == 0) {
+            self->instancing = 0;
+        }
+        else {
+            self->instance_projection_location = glGetUniformLocation(self->instance_program, "projection");
+            self->instance_modelview_location = glGetUniformLocation(self->instance_program, "modelview");
+            glGenBuffers(1, &self->instance_buffer);
+        }
+    }
+    // core profiles have no quads or wide lines to instance
+    if (! self->instancing || self->recording != NULL || Renderer_ExtrudesLines(self, mode, width) ||
+        (self->backend == RENDERER_BACKEND_CORE && (mode == GL_QUADS || mode == GL_QUAD_STRIP))) {
+        int result = Renderer_AppendInstances(self, mesh, data, count, mode, width, smoothing);
+        Coordinates_Release(&instances);
+        if (result != 0) {
+            return NULL;
+        }
+        Py_RETURN_NONE;
+    }
+
+    if (Renderer_Flush(self) != 0) {
+        Coordinates_Release(&instances);
+        return NULL;
+    }
+    Renderer_LoadModelview(self, RENDERER_MODELVIEW_TRANSFORM);
+    if (Renderer_IsLineMode(mode)) {
+        GLState_LineWidth(&self->gl, width);
+        GLState_LineSmooth(&self->gl, smoothing);
+    }
+    GLState_Blend(&self->gl, self->blend);
+    GLState_BindTexture(&self->gl, 0);
+    GLState_UseProgram(&self->gl, self->instance_program);
+    if (self->backend == RENDERER_BACKEND_CORE) {
+        GLfloat matrix[16];
+        Transform_ToMatrix(TransformStack_Top(&self->transforms), matrix);
+        glUniformMatrix4fv(self->instance_projection_location, 1, GL_FALSE, self->projection);
+        glUniformMatrix4fv(self->instance_modelview_location, 1, GL_FALSE, matrix);
+        glBindVertexArray(self->vertex_array);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, mesh->buffer);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 2, mesh->type, GL_FALSE, 0, (const GLvoid*)0);
+    glBindBuffer(GL_ARRAY_BUFFER, self->instance_buffer);
+    glBufferData(GL_ARRAY_BUFFER, instances.length * sizeof(GLfloat), data, GL_STREAM_DRAW);
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, INSTANCE_COMPONENTS * sizeof(GLfloat), (const GLvoid*)0);
+    glVertexAttribDivisor(1, 1);
+    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, INSTANCE_COMPONENTS * sizeof(GLfloat), (const GLvoid*)(4 * sizeof(GLfloat)));
+    glVertexAttribDivisor(2, 1);
+    if (mode == GL_POLYGON) {
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->index_buffer);
+        glDrawElementsInstanced(GL_TRIANGLES, mesh->index_count, GL_UNSIGNED_INT, (const GLvoid*)0, count);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    }
+    else {
+        glDrawArraysInstanced(mode, 0, mesh->length, count);
+    }
+    glVertexAttribDivisor(1, 0);
+    glVertexAttribDivisor(2, 0);
+    glDisableVertexAttribArray(2);
+    glDisableVertexAttribArray(1);
+    glDisableVertexAttribArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    if (self->backend == RENDERER_BACKEND_CORE) {
+        glBindVertexArray(0);
+    }
+    // back to the fixed function pipeline, or the core program
+    GLState_UseProgram(&self->gl, self->program);
+    self->draw_calls++;
+    Coordinates_Release(&instances);
+    Py_RETURN_NONE;
+}
+
+static PyObject*
+Renderer__draw_texture_region(Renderer* self, PyObject* args) {
+    Atlas* atlas;
+    GLuint texture;
+    GLfloat u0, v0, u1, v1, x, y, width, height;
+    GLfloat data[8], texture_data[8];
+    if (! PyArg_ParseTuple(args, "O!Iffffffff", &AtlasType, &atlas, &texture, &u0, &v0, &u1, &v1, &x, &y, &width, &height)) {
+        return NULL;
+    }
+    if (Renderer_MakeCurrent(self) != 0) {
+        return NULL;
+    }
+    // only pages of the atlas are known to be alive in this context
+    if (atlas->renderer != self) {
+        PyErr_SetString(PyExc_ValueError, "atlas belongs to another renderer");
+        return NULL;
+    }
+    if (! Atlas_HasPage(atlas, texture)) {
+        PyErr_SetString(PyExc_ValueError, "texture is not a page of the atlas");
+        return NULL;
+    }
+    if (Renderer_KeepTexture(self, (PyObject*)atlas) != 0) {
+        return NULL;
+    }
+    data[0] = x;         data[1] = y;
+    data[2] = x + width; data[3] = y;
+    data[4] = x + width; data[5] = y + height;
+    data[6] = x;         data[7] = y + height;
+    texture_data[0] = u0; texture_data[1] = v0;
+    texture_data[2] = u1; texture_data[3] = v0;
+    texture_data[4] = u1; texture_data[5] = v1;
+    texture_data[6] = u0; texture_data[7] = v1;
+
+    if (Renderer_Batches(self)) {
+        BatchState state;
+        Renderer_BatchState(self, &state, GL_TRIANGLES, texture);
+        if (Renderer_AppendPrimitive(self, &state, GL_TRIANGLE_FAN, data, texture_data, 4, self->color) != 0) {
+            return NULL;
+        }
+        if (Renderer_FlushUnbatched(self) != 0) {
+            return NULL;
+        }
+        Py_RETURN_NONE;
+    }
+
+    Renderer_LoadModelview(self, RENDERER_MODELVIEW_TRANSFORM);
+    Renderer_ImmediateState(self, texture, GLSTATE_VERTEX_ARRAY | GLSTATE_TEXTURE_COORD_ARRAY);
+    glVertexPointer(2, GL_FLOAT, 0, data);
+    glTexCoordPointer(2, GL_FLOAT, 0, texture_data);
+    glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
+    self->draw_calls++;
+    Py_RETURN_NONE;
+}
+
+static PyObject*
+Renderer__draw_text(Renderer* self, PyObject* args) {
+    Font* font;
+    PyObject* text;
+    GLfloat x, y, r, g, b, a;
+    GLfloat data[8], texture_data[8];
+    GLubyte color[4];
+    if (! PyArg_ParseTuple(args, "O!Uff|(ffff)", &FontType, &font, &text, &x, &y, &r, &g, &b, &a)) {
+        return NULL;
+    }
+    if (Renderer_MakeCurrent(self) != 0) {
+        return NULL;
+    }
+    memcpy(color, self->color, sizeof(color));
+    if (PyTuple_GET_SIZE(args) > 4) {
+        color[0] = (GLubyte)(r * 255.0f + 0.5f);
+        color[1] = (GLubyte)(g * 255.0f + 0.5f);
+        color[2] = (GLubyte)(b * 255.0f + 0.5f);
+        color[3] = (GLubyte)(a * 255.0f + 0.5f);
+    }
+    if (Font_Layout(font, text) != 0) {
+        return NULL;
+    }
+    // one quad per glyph from the font atlas, laid out like Font.render_text
+    for (int i = 0; i < font->layout.length; i++) {
+        const FontGlyphPlacement* placement = &font->layout.placements[i];
+        FontGlyphPixmap* glyph = placement->glyph;
+        BatchState state;
+        GLfloat left, top, u0, v0, u1, v1;
+        if (Font_AtlasGlyph(font, self, glyph) != 0) {
+            return NULL;
+        }
+        if (glyph->texture == 0) {
+            continue;
+        }
+        if (Renderer_KeepTexture(self, (PyObject*)font->atlas) != 0) {
+            return NULL;
+        }
+        left = x + placement->x + glyph->x_offset;
+        top = y + placement->y + glyph->y_offset;
+        data[0] = left;                data[1] = top;
+        data[2] = left + glyph->width; data[3] = top;
+        data[4] = left + glyph->width; data[5] = top + glyph->height;
+        data[6] = left;                data[7] = top + glyph->height;
+        u0 = (GLfloat)glyph->atlas_x / font->atlas->width;
+        v0 = (GLfloat)glyph->atlas_y / font->atlas->height;
+        u1 = (GLfloat)(glyph->atlas_x + glyph->width) / font->atlas->width;
+        v1 = (GLfloat)(glyph->atlas_y + glyph->height) / font->atlas->height;
+        texture_data[0] = u0; texture_data[1] = v0;
+        texture_data[2] = u1; texture_data[3] = v0;
+        texture_data[4] = u1; texture_data[5] = v1;
+        texture_data[6] = u0; texture_data[7] = v1;
+        Renderer_BatchState(self, &state, GL_TRIANGLES, glyph->texture);
+        if (Renderer_AppendPrimitive(self, &state, GL_TRIANGLE_FAN, data, texture_data, 4, color) != 0) {
+            return NULL;
+        }
+    }
+    if (Renderer_FlushUnbatched(self) != 0) {
+        return NULL;
+    }
     Py_RETURN_NONE;
 }
 
 static PyObject*
-Renderer_rotate(Renderer* self, PyObject* args) {
-    float angle;
-    if (! PyArg_ParseTuple(args, "f", &angle))
-    {
+Renderer__read_pixels(Renderer* self, PyObject* args) {
+    int width, height, size, components = 3;
+    GLubyte* buffer;
+    PyObject* pixels;
+    if (! PyArg_ParseTuple(args, "ii", &width, &height)) {
         return NULL;
     }
-    glRotatef(angle, 0.0f, 0.0f, 1.0f);
-    Py_RETURN_NONE;
+    if (Renderer_Flush(self) != 0) {
+        return NULL;
+    }
+    size = width * height * components;
+    buffer = (GLubyte*)malloc(size ? size : 1);
+    if (buffer == NULL) {
+        return PyErr_NoMemory();
+    }
+    pixels = PyBytes_FromStringAndSize(NULL, size);
+    if (pixels == NULL) {
+        free(buffer);
+        return NULL;
+    }
+    // rows are tightly packed, whatever the width
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, buffer);
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    Capture_FlipRows((GLubyte*)PyBytes_AS_STRING(pixels), buffer, width, height);
+    free(buffer);
+    return pixels;
 }
 
 static PyObject*
-Renderer_save(Renderer* self) {
-    glPushMatrix();
+Renderer_request_capture(Renderer* self) {
+    if (Renderer_Flush(self) != 0) {
+        return NULL;
+    }
+    if (Capture_Request(&self->capture, self->width, self->height) != 0) {
+        return PyErr_NoMemory();
+    }
     Py_RETURN_NONE;
 }
 
 static PyObject*
-Renderer_translate(Renderer* self, PyObject* args) {
-    float x, y;
-    if (! PyArg_ParseTuple(args, "ff", &x, &y)) {
+Renderer__poll_capture(Renderer* self, PyObject* args) {
+    PyObject* wait;
+    if (! PyArg_ParseTuple(args, "O", &wait)) {
         return NULL;
     }
-    glTranslatef(x, y, 0.0f);
-    Py_RETURN_NONE;
+    if (Renderer_MakeCurrent(self) != 0) {
+        return NULL;
+    }
+    return Capture_Poll(&self->capture, PyObject_IsTrue(wait) == 1);
 }
 
 static PyObject*
-Renderer__clear(Renderer* self, PyObject* args) {
+Renderer__set_color(Renderer* self, PyObject* args) {
     float r, g, b, a;
     if (! PyArg_ParseTuple(args, "ffff", &r, &g, &b, &a)) {
         return NULL;
     }
-    glClearColor(r, g, b, a);
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
-    glLoadIdentity();
+    self->color[0] = (GLubyte)(r * 255.0f + 0.5f);
+    self->color[1] = (GLubyte)(g * 255.0f + 0.5f);
+    self->color[2] = (GLubyte)(b * 255.0f + 0.5f);
+    self->color[3] = (GLubyte)(a * 255.0f + 0.5f);
     Py_RETURN_NONE;
 }
 
 static PyObject*
-Renderer__draw_line_strip(Renderer* self, PyObject* args) {
-    PyObject* coordinates;
-    PyObject* smooth;
-    double* data;
-    float width;
-    int length;
-    if (! PyArg_ParseTuple(args, "OfO", &coordinates, &width, &smooth)) {
+Renderer__set_blend_mode(Renderer* self, PyObject* args) {
+    int blend;
+    if (! PyArg_ParseTuple(args, "i", &blend)) {
         return NULL;
     }
-    length = PySequence_Length(coordinates);
-    data = (double*)malloc(length * sizeof(double));
-    for(int i = 0; i < length; i++) {
-        data[i] = PyFloat_AsDouble(PySequence_GetItem(coordinates, i));
+    if (blend < BATCH_BLEND_NONE || blend > BATCH_BLEND_ADDITIVE) {
+        PyErr_SetString(PyExc_ValueError, "unknown blend mode");
+        return NULL;
     }
+    self->blend = blend;
+    Py_RETURN_NONE;
+}
 
-    if (smooth && PyBool_Check(smooth) && PyObject_IsTrue(smooth)) {
-        glEnable(GL_LINE_SMOOTH);
+static PyObject*
+Renderer__begin_recording(Renderer* self, PyObject* args) {
+    CommandList* recording;
+    if (! PyArg_ParseTuple(args, "O!", &CommandListType, &recording)) {
+        return NULL;
     }
-
-    glBindTexture(GL_TEXTURE_2D, 0);
-    glEnableClientState(GL_VERTEX_ARRAY);
-    glVertexPointer(2, GL_DOUBLE, 0, data);
-    glLineWidth(width);
-    glDrawArrays(GL_LINE_STRIP, 0, length / 2);
-    glDisableClientState(GL_VERTEX_ARRAY);
-    glDisable(GL_LINE_SMOOTH);
-    free(data);
+    if (self->recording != NULL) {
+        PyErr_SetString(PyExc_RuntimeError, "renderer is already recording");
+        return NULL;
+    }
+    if (CommandList_Begin(recording, (PyObject*)self) != 0) {
+        return NULL;
+    }
+    if (TransformStack_Push(&self->transforms) != 0) {
+        return PyErr_NoMemory();
+    }
+    Transform_Identity(TransformStack_Top(&self->transforms));
+    Renderer_TransformChanged(self);
+    Py_INCREF(recording);
+    self->recording = recording;
+    self->recording_depth = self->transforms.depth;
     Py_RETURN_NONE;
 }
 
 static PyObject*
-Renderer__draw_polygon(Renderer* self, PyObject* args) {
-    PyObject* coordinates;
-    double* data;
-    int length;
-    if (! PyArg_ParseTuple(args, "O", &coordinates)) {
+Renderer_end_recording(Renderer* self) {
+    CommandList* recording = self->recording;
+    if (recording == NULL) {
+        PyErr_SetString(PyExc_RuntimeError, "renderer is not recording");
         return NULL;
     }
+    // including saves left unmatched during the recording
+    self->transforms.depth = self->recording_depth - 1;
+    Renderer_TransformChanged(self);
+    self->recording = NULL;
+    return (PyObject*)recording;
+}
 
-    length = PySequence_Length(coordinates);
-    data = (double*)malloc(length * sizeof(double));
-    for(int i = 0; i < length; i++) {
-        data[i] = PyFloat_AsDouble(PySequence_GetItem(coordinates, i));
+static PyObject*
+Renderer__replay(Renderer* self, PyObject* args) {
+    CommandList* commands;
+    Transform transform;
+    float x, y, angle, scale;
+    if (! PyArg_ParseTuple(args, "O!ffff", &CommandListType, &commands, &x, &y, &angle, &scale)) {
+        return NULL;
+    }
+    if (Renderer_MakeCurrent(self) != 0) {
+        return NULL;
+    }
+    if (commands == self->recording) {
+        PyErr_SetString(PyExc_ValueError, "command list can't be replayed into itself");
+        return NULL;
+    }
+    // its textures live in the context of the renderer that recorded it
+    if (commands->renderer != NULL && commands->renderer != (PyObject*)self) {
+        PyErr_SetString(PyExc_ValueError, "command list was recorded by another renderer");
+        return NULL;
+    }
+    if (Renderer_KeepTexture(self, (PyObject*)commands) != 0) {
+        return NULL;
+    }
+    transform = *TransformStack_Top(&self->transforms);
+    Transform_Translate(&transform, x, y);
+    Transform_Rotate(&transform, angle);
+    Transform_Scale(&transform, scale, scale);
+    Renderer_LoadModelview(self, RENDERER_MODELVIEW_IDENTITY);
+    for (int i = 0; i < commands->commands.length; i++) {
+        const QueueItem* item = &commands->commands.items[i];
+        const BatchVertex* source = commands->commands.vertices + item->first;
+        BatchVertex* vertices = Renderer_Append(self, &item->state, item->count);
+        if (vertices == NULL) {
+            return NULL;
+        }
+        for (int k = 0; k < item->count; k++) {
+            vertices[k] = source[k];
+            vertices[k].x = transform.a * source[k].x + transform.c * source[k].y + transform.x;
+            vertices[k].y = transform.b * source[k].x + transform.d * source[k].y + transform.y;
+        }
+    }
+    if (Renderer_FlushUnbatched(self) != 0) {
+        return NULL;
     }
-
-    glBindTexture(GL_TEXTURE_2D, 0);
-    glEnableClientState(GL_VERTEX_ARRAY);
-    glVertexPointer(2, GL_DOUBLE, 0, data);
-    glDrawArrays(GL_POLYGON, 0, length / 2);
-    glDisableClientState(GL_VERTEX_ARRAY);
-    free(data);
     Py_RETURN_NONE;
 }
 
 static PyObject*
-Renderer__draw_textured_polygon(Renderer* self, PyObject* args) {
-    PyObject* coordinates;
-    PyObject* texture_coordinates;
-    double* data;
-    double* texture_data;
-    int texture, length;
-    if (! PyArg_ParseTuple(args, "OOi", &coordinates, &texture_coordinates, &texture)) {
+Renderer_flush(Renderer* self) {
+    if (Renderer_Flush(self) != 0) {
         return NULL;
     }
+    Py_RETURN_NONE;
+}
 
-    length = PySequence_Length(coordinates);
+static PyObject*
+Renderer_get_batching(Renderer* self, void* closure) {
+    return PyBool_FromLong(self->batching);
+}
 
-    data = (double*)malloc(length * sizeof(double));
-    for(int i = 0; i < length; i++) {
-        data[i] = PyFloat_AsDouble(PySequence_GetItem(coordinates, i));
+static int
+Renderer_set_batching(Renderer* self, PyObject* value, void* closure) {
+    int batching;
+    if (value == NULL) {
+        PyErr_SetString(PyExc_TypeError, "cannot delete batching attribute");
+        return -1;
     }
+    batching = PyObject_IsTrue(value);
+    if (batching < 0) {
+        return -1;
+    }
+    if (! batching) {
+        if (Renderer_Flush(self) != 0) {
+            return -1;
+        }
+    }
+    self->batching = batching;
+    return 0;
+}
+
+static PyObject*
+Renderer_get_sorting(Renderer* self, void* closure) {
+    return PyBool_FromLong(self->sorting);
+}
 
-    texture_data = (double*)malloc(length * sizeof(double));
-    for(int i = 0; i < length; i++) {
-        texture_data[i] = PyFloat_AsDouble(PySequence_GetItem(texture_coordinates, i));
+static int
+Renderer_set_sorting(Renderer* self, PyObject* value, void* closure) {
+    int sorting;
+    if (value == NULL) {
+        PyErr_SetString(PyExc_TypeError, "cannot delete sorting attribute");
+        return -1;
+    }
+    sorting = PyObject_IsTrue(value);
+    if (sorting < 0) {
+        return -1;
+    }
+    if (! sorting) {
+        if (Renderer_Flush(self) != 0) {
+            return -1;
+        }
     }
+    self->sorting = sorting;
+    return 0;
+}
 
-    glBindTexture(GL_TEXTURE_2D, texture);
-    glEnableClientState(GL_TEXTURE_COORD_ARRAY);
-    glEnableClientState(GL_VERTEX_ARRAY);
-    glVertexPointer(2, GL_DOUBLE, 0, (const GLvoid *)data);
-    glTexCoordPointer(2, GL_DOUBLE, 0, (const GLvoid *)texture_data);
-    glDrawArrays(GL_POLYGON, 0, length / 2);
-    glDisableClientState(GL_VERTEX_ARRAY);
-    glDisableClientState(GL_TEXTURE_COORD_ARRAY);
-    free(data);
-    free(texture_data);
-    Py_RETURN_NONE;
+static PyObject*
+Renderer_get_layer(Renderer* self, void* closure) {
+    return PyLong_FromLong(self->layer);
+}
+
+static int
+Renderer_set_layer(Renderer* self, PyObject* value, void* closure) {
+    long layer = value ? PyLong_AsLong(value) : -1;
+    if (layer == -1 && PyErr_Occurred()) {
+        return -1;
+    }
+    if (layer < 0 || layer > QUEUE_MAX_LAYER) {
+        PyErr_Format(PyExc_ValueError, "layer must be between 0 and %d", QUEUE_MAX_LAYER);
+        return -1;
+    }
+    self->layer = (int)layer;
+    return 0;
 }
 
 static PyObject*
-Renderer__generate_texture(Renderer* self, PyObject* args) {
-    GLuint id;
-    Py_buffer data;
-    int width, height, components, format = GL_RGB;
-    if (! PyArg_ParseTuple(args, "y*iii", &data, &width, &height, &components)) {
-        return NULL;
+Renderer_get_depth(Renderer* self, void* closure) {
+    return PyLong_FromLong(self->depth);
+}
+
+static int
+Renderer_set_depth(Renderer* self, PyObject* value, void* closure) {
+    long depth = value ? PyLong_AsLong(value) : -1;
+    if (depth == -1 && PyErr_Occurred()) {
+        return -1;
     }
-    // TODO: support GL_ALPHA, GL_LUMINANCE, GL_LUMINANCE_ALPHA, GL_RGB, GL_RGBA
-    if (components == 4) {
-        format = GL_RGBA;
+    if (depth < 0 || depth > QUEUE_MAX_DEPTH) {
+        PyErr_Format(PyExc_ValueError, "depth must be between 0 and %d", QUEUE_MAX_DEPTH);
+        return -1;
     }
+    self->depth = (int)depth;
+    return 0;
+}
 
-    glGenTextures(1, &id);
-    glBindTexture(GL_TEXTURE_2D, id);
-    glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data.buf);
+static PyObject*
+Renderer_get_vertex_format(Renderer* self, void* closure) {
+    return PyLong_FromLong(self->vertex_format);
+}
 
-    return Py_BuildValue("i", id);
+static int
+Renderer_set_vertex_format(Renderer* self, PyObject* value, void* closure) {
+    long format = value ? PyLong_AsLong(value) : -1;
+    if (format == -1 && PyErr_Occurred()) {
+        return -1;
+    }
+    if (format != COORDINATES_FLOAT32 && format != COORDINATES_INT16) {
+        PyErr_SetString(PyExc_ValueError, "vertex format must be VERTEX_FLOAT32 or VERTEX_INT16");
+        return -1;
+    }
+    self->vertex_format = (int)format;
+    return 0;
 }
 
 static PyObject*
-Renderer__read_pixels(Renderer* self, PyObject* args) {
-    int width, height, size, row_size, components = 3;
-    GLubyte* buffer;
-    GLubyte* data;
-    PyObject* pixels;
-    if (! PyArg_ParseTuple(args, "ii", &width, &height)) {
-        return NULL;
+Renderer_get_texture_coordinate_format(Renderer* self, void* closure) {
+    return PyLong_FromLong(self->texture_format);
+}
+
+static int
+Renderer_set_texture_coordinate_format(Renderer* self, PyObject* value, void* closure) {
+    long format = value ? PyLong_AsLong(value) : -1;
+    if (format == -1 && PyErr_Occurred()) {
+        return -1;
     }
-    row_size = width * components;
-    size = height * row_size;
-    buffer = (GLubyte*)malloc(size * sizeof(GLubyte));
-    data = (GLubyte*)malloc(size * sizeof(GLubyte));
-    glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, buffer);
-    // flip Y
-    for (int y = 0; y < height; y++) {
-        for (int x = 0; x < row_size; x++) {
-            data[y * row_size + x] = buffer[(height - y - 1) * row_size + x];
-        }
+    if (format != COORDINATES_FLOAT32 && format != COORDINATES_UNORM16) {
+        PyErr_SetString(PyExc_ValueError, "texture coordinate format must be VERTEX_FLOAT32 or VERTEX_UNORM16");
+        return -1;
     }
-    pixels = PyBytes_FromStringAndSize((const char*)data, size);
-    free(data);
-    free(buffer);
-    return pixels;
+    self->texture_format = (int)format;
+    return 0;
 }
 
 static PyObject*
-Renderer__set_color(Renderer* self, PyObject* args) {
-    float r, g, b, a;
-    if (! PyArg_ParseTuple(args, "ffff", &r, &g, &b, &a)) {
-        return NULL;
+Renderer_get_instancing(Renderer* self, void* closure) {
+    return PyBool_FromLong(self->instancing);
+}
+
+static int
+Renderer_set_instancing(Renderer* self, PyObject* value, void* closure) {
+    int instancing = value ? PyObject_IsTrue(value) : -1;
+    if (instancing < 0) {
+        if (! PyErr_Occurred()) {
+            PyErr_SetString(PyExc_TypeError, "cannot delete instancing attribute");
+        }
+        return -1;
     }
-    glColor4f(r, g, b, a);
-    Py_RETURN_NONE;
+    if (instancing && ! OpenGL_HasInstancing) {
+        PyErr_SetString(PyExc_RuntimeError, "instanced drawing is not supported by this context");
+        return -1;
+    }
+    self->instancing = instancing;
+    return 0;
+}
+
+static PyObject*
+Renderer_get_width(Renderer* self, void* closure) {
+    return PyLong_FromLong(self->width);
+}
+
+static PyObject*
+Renderer_get_height(Renderer* self, void* closure) {
+    return PyLong_FromLong(self->height);
+}
+
+static PyObject*
+Renderer_get_backend(Renderer* self, void* closure) {
+    return PyLong_FromLong(self->backend);
+}
+
+static PyObject*
+Renderer_get_draw_calls(Renderer* self, void* closure) {
+    return PyLong_FromUnsignedLong(self->draw_calls + self->batch.draw_calls);
+}
+
+static PyObject*
+Renderer_get_state_changes(Renderer* self, void* closure) {
+    return PyLong_FromUnsignedLong(self->gl.issued);
+}
+
+static PyObject*
+Renderer_get_skipped_state_changes(Renderer* self, void* closure) {
+    return PyLong_FromUnsignedLong(self->gl.skipped);
 }
 
 static PyGetSetDef Renderer_getsetters[] = {
+    {
+        "batching",
+        (getter)Renderer_get_batching,
+        (setter)Renderer_set_batching,
+        "Collects draws into one vertex stream until state changes.",
+        NULL
+    },
+    {
+        "sorting",
+        (getter)Renderer_get_sorting,
+        (setter)Renderer_set_sorting,
+        "Holds batched draws until the next flush and sends them sorted by layer, depth, then state.",
+        NULL
+    },
+    {
+        "layer",
+        (getter)Renderer_get_layer,
+        (setter)Renderer_set_layer,
+        "Layer of the following draws when sorting, from 0 (drawn first) to 255.",
+        NULL
+    },
+    {
+        "depth",
+        (getter)Renderer_get_depth,
+        (setter)Renderer_set_depth,
+        "Depth of the following draws within their layer when sorting, from 0 (drawn first) to 65535.",
+        NULL
+    },
+    {
+        "vertex_format",
+        (getter)Renderer_get_vertex_format,
+        (setter)Renderer_set_vertex_format,
+        "Format that converted vertex coordinates are sent in (VERTEX_FLOAT32, VERTEX_INT16).",
+        NULL
+    },
+    {
+        "texture_coordinate_format",
+        (getter)Renderer_get_texture_coordinate_format,
+        (setter)Renderer_set_texture_coordinate_format,
+        "Format that converted texture coordinates are sent in (VERTEX_FLOAT32, VERTEX_UNORM16).",
+        NULL
+    },
+    {
+        "instancing",
+        (getter)Renderer_get_instancing,
+        (setter)Renderer_set_instancing,
+        "Draws instances with one instanced draw call instead of expanding them on the CPU.",
+        NULL
+    },
+    {
+        "width",
+        (getter)Renderer_get_width,
+        NULL,
+        "Width of the drawing surface, in pixels.",
+        NULL
+    },
+    {
+        "height",
+        (getter)Renderer_get_height,
+        NULL,
+        "Height of the drawing surface, in pixels.",
+        NULL
+    },
+    {
+        "backend",
+        (getter)Renderer_get_backend,
+        NULL,
+        "Pipeline the context was created for (BACKEND_LEGACY, BACKEND_CORE).",
+        NULL
+    },
+    {
+        "draw_calls",
+        (getter)Renderer_get_draw_calls,
+        NULL,
+        "Number of draw calls issued to OpenGL so far.",
+        NULL
+    },
+    {
+        "state_changes",
+        (getter)Renderer_get_state_changes,
+        NULL,
+        "Number of texture, program, blending, line width and smoothing, client array and color changes issued to OpenGL so far.",
+        NULL
+    },
+    {
+        "skipped_state_changes",
+        (getter)Renderer_get_skipped_state_changes,
+        NULL,
+        "Number of state changes skipped so far, as they would have set what was already set.",
+        NULL
+    },
     {NULL}
 };
 
 static PyMethodDef Renderer_methods[] = {
+    {
+        "flush",
+        (PyCFunction)Renderer_flush,
+        METH_NOARGS,
+        "Draws everything collected in the current batch."
+    },
+    {
+        "request_capture",
+        (PyCFunction)Renderer_request_capture,
+        METH_NOARGS,
+        "Starts copying the current frame to memory without waiting for it."
+    },
     {
         "restore",
         (PyCFunction)Renderer_restore,
@@ -267,12 +2066,66 @@ static PyMethodDef Renderer_methods[] = {
         METH_VARARGS,
         "..."
     },
+    {
+        "_begin_recording",
+        (PyCFunction)Renderer__begin_recording,
+        METH_VARARGS,
+        "..."
+    },
+    {
+        "end_recording",
+        (PyCFunction)Renderer_end_recording,
+        METH_NOARGS,
+        "Stops recording and returns the CommandList of draws made since begin_recording()."
+    },
+    {
+        "_replay",
+        (PyCFunction)Renderer__replay,
+        METH_VARARGS,
+        "..."
+    },
+    {
+        "_draw_instances",
+        (PyCFunction)Renderer__draw_instances,
+        METH_VARARGS,
+        "..."
+    },
+    {
+        "_draw_line_loop",
+        (PyCFunction)Renderer__draw_line_loop,
+        METH_VARARGS,
+        "..."
+    },
     {
         "_draw_line_strip",
         (PyCFunction)Renderer__draw_line_strip,
         METH_VARARGS,
         "..."
     },
+    {
+        "_draw_line_loops",
+        (PyCFunction)Renderer__draw_line_loops,
+        METH_VARARGS,
+        "..."
+    },
+    {
+        "_draw_rectangles",
+        (PyCFunction)Renderer__draw_rectangles,
+        METH_VARARGS,
+        "..."
+    },
+    {
+        "_draw_circles",
+        (PyCFunction)Renderer__draw_circles,
+        METH_VARARGS,
+        "..."
+    },
+    {
+        "_draw_mesh",
+        (PyCFunction)Renderer__draw_mesh,
+        METH_VARARGS,
+        "..."
+    },
     {
         "_draw_polygon",
         (PyCFunction)Renderer__draw_polygon,
@@ -286,8 +2139,20 @@ static PyMethodDef Renderer_methods[] = {
         "..."
     },
     {
-        "_generate_texture",
-        (PyCFunction)Renderer__generate_texture,
+        "_draw_text",
+        (PyCFunction)Renderer__draw_text,
+        METH_VARARGS,
+        "..."
+    },
+    {
+        "_draw_texture_region",
+        (PyCFunction)Renderer__draw_texture_region,
+        METH_VARARGS,
+        "..."
+    },
+    {
+        "_poll_capture",
+        (PyCFunction)Renderer__poll_capture,
         METH_VARARGS,
         "..."
     },
@@ -297,6 +2162,12 @@ static PyMethodDef Renderer_methods[] = {
         METH_VARARGS,
         "..."
     },
+    {
+        "_set_blend_mode",
+        (PyCFunction)Renderer__set_blend_mode,
+        METH_VARARGS,
+        "..."
+    },
     {
         "_set_color",
         (PyCFunction)Renderer__set_color,
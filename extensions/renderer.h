@@ -11,13 +11,93 @@
 #include <SDL2/SDL_opengl.h>
 
 #include "window.h"
+#include "batch.h"
+#include "capture.h"
+#include "circles.h"
+#include "commandlist.h"
+#include "glstate.h"
+#include "opengl.h"
+#include "polyline.h"
+#include "queue.h"
+#include "transform.h"
+#include "triangulate.h"
 
-typedef struct {
+#define RENDERER_BACKEND_LEGACY 0
+#define RENDERER_BACKEND_CORE   1
+
+#define RENDERER_MODELVIEW_UNKNOWN   -1
+#define RENDERER_MODELVIEW_IDENTITY  0
+#define RENDERER_MODELVIEW_TRANSFORM 1
+
+typedef struct Renderer {
     PyObject_HEAD
     Window* window;
     SDL_GLContext context;
+    int (*make_current)(struct Renderer* self);
+    int width;
+    int height;
+    int backend;
+    GLuint program;
+    GLint projection_location;
+    GLint modelview_location;
+    GLuint vertex_array;
+    GLfloat projection[16];
+    GLState gl;
+    Batch batch;
+    RenderQueue queue;
+    int sorting;
+    int layer;
+    int depth;
+    // draws go into the list instead of the batch while recording
+    CommandList* recording;
+    int recording_depth;
+    TransformStack transforms;
+    int modelview;
+    GLfloat* transformed;
+    int transformed_capacity;
+    TriangulationCache triangulations;
+    Polyline polyline;
+    CircleCache circles;
+    int batching;
+    int blend;
+    int vertex_format;
+    int texture_format;
+    GLubyte color[4];
+    int instancing;
+    GLuint instance_program;
+    GLint instance_projection_location;
+    GLint instance_modelview_location;
+    GLuint instance_buffer;
+    Capture capture;
+    unsigned long draw_calls;
 } Renderer;
 
 extern PyTypeObject RendererType;
 
+// Makes the renderer current and draws everything it collected.
+int
+Renderer_Flush(Renderer* self);
+
+// Shared with other kinds of rendering contexts: InitState resets drawing
+// state for a target of the given size, InitPipeline sets up OpenGL once
+// a context is current.
+int
+Renderer_InitState(Renderer* self, int width, int height, int backend);
+
+int
+Renderer_InitPipeline(Renderer* self, OpenGL_Loader loader);
+
+// Makes the context of a renderer current, unless it already is.
+int
+Renderer_MakeCurrent(Renderer* self);
+
+// Returns the renderer whose context is current, if any.
+Renderer*
+Renderer_GetCurrent(void);
+
+// Deletes a texture on the context that created it, flushing draws that
+// still sample it, then switches back to the previously current context.
+void
+Renderer_DeleteTexture(Renderer* self, GLuint texture);
+
 #endif /* RENDERER_H */
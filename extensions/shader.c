@@ -0,0 +1,62 @@
+#include <stdio.h>
+
+#include "shader.h"
+#include "opengl.h"
+
+static char error[512] = "no error";
+
+static GLuint
+Shader_Compile(GLenum type, const char* source) {
+    GLuint shader;
+    GLint status;
+    shader = glCreateShader(type);
+    glShaderSource(shader, 1, &source, NULL);
+    glCompileShader(shader);
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+    if (! status) {
+        glGetShaderInfoLog(shader, sizeof(error), NULL, error);
+        glDeleteShader(shader);
+        return 0;
+    }
+    return shader;
+}
+
+GLuint
+Shader_CreateProgram(const char* vertex_source, const char* fragment_source, const char* const* attributes) {
+    GLuint program, vertex, fragment;
+    GLint status;
+    if (! OpenGL_HasShaders) {
+        snprintf(error, sizeof(error), "shaders require OpenGL 2.0");
+        return 0;
+    }
+    vertex = Shader_Compile(GL_VERTEX_SHADER, vertex_source);
+    if (vertex == 0) {
+        return 0;
+    }
+    fragment = Shader_Compile(GL_FRAGMENT_SHADER, fragment_source);
+    if (fragment == 0) {
+        glDeleteShader(vertex);
+        return 0;
+    }
+    program = glCreateProgram();
+    glAttachShader(program, vertex);
+    glAttachShader(program, fragment);
+    for (GLuint location = 0; attributes != NULL && attributes[location] != NULL; location++) {
+        glBindAttribLocation(program, location, attributes[location]);
+    }
+    glLinkProgram(program);
+    glDeleteShader(vertex);
+    glDeleteShader(fragment);
+    glGetProgramiv(program, GL_LINK_STATUS, &status);
+    if (! status) {
+        glGetProgramInfoLog(program, sizeof(error), NULL, error);
+        glDeleteProgram(program);
+        return 0;
+    }
+    return program;
+}
+
+char*
+Shader_GetError() {
+    return error;
+}
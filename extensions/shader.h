@@ -0,0 +1,19 @@
+#ifndef SHADER_H
+#define SHADER_H
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_opengl.h>
+
+// Compiles and links a program, binding the NULL terminated attribute
+// names to locations 0, 1, 2 ... Returns 0 on failure.
+GLuint
+Shader_CreateProgram(const char* vertex_source, const char* fragment_source, const char* const* attributes);
+
+char*
+Shader_GetError();
+
+#endif /* SHADER_H */
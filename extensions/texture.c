@@ -0,0 +1,474 @@
+#include <stdlib.h>
+
+#include "texture.h"
+
+static void
+Texture_SetParameters(Texture* self) {
+    GLenum minify = self->filter;
+    if (self->mipmaps) {
+        minify = self->filter == GL_LINEAR ? GL_LINEAR_MIPMAP_LINEAR : GL_NEAREST_MIPMAP_NEAREST;
+    }
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, self->filter);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, minify);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, self->wrap);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, self->wrap);
+}
+
+// The pixel format of an image with the given number of components.
+static GLenum
+Texture_Format(Texture* self, int components) {
+    if (components == 4) {
+        return GL_RGBA;
+    }
+    if (components == 3) {
+        return GL_RGB;
+    }
+    // core profiles have neither luminance nor alpha textures
+    if (self->renderer->backend == RENDERER_BACKEND_CORE) {
+        return GL_RED;
+    }
+    return self->coverage ? GL_ALPHA : GL_LUMINANCE;
+}
+
+// Allocates storage for the bound texture, red spread into place on core
+// profiles: grey for luminance, white tinted by the draw color for coverage.
+static void
+Texture_Allocate(Texture* self, GLenum format, const GLvoid* pixels) {
+    glTexImage2D(GL_TEXTURE_2D, 0, format, self->width, self->height, 0, format, GL_UNSIGNED_BYTE, pixels);
+    if (self->renderer->backend == RENDERER_BACKEND_CORE) {
+        static const GLint luminance[] = {GL_RED, GL_RED, GL_RED, GL_ONE};
+        static const GLint coverage[] = {GL_ONE, GL_ONE, GL_ONE, GL_RED};
+        static const GLint identity[] = {GL_RED, GL_GREEN, GL_BLUE, GL_ALPHA};
+        const GLint* swizzle = identity;
+        if (format == GL_RED) {
+            swizzle = self->coverage ? coverage : luminance;
+        }
+        glTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_RGBA, swizzle);
+    }
+    self->format = format;
+}
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define TEXTURE_SSE2
+#endif
+
+// Halves an image with a 2x2 box filter, an odd last row or column is
+// averaged with itself.
+static void
+Texture_Downsample(const GLubyte* pixels, int width, int height, int components, GLubyte* output) {
+    int output_width = width > 1 ? width / 2 : 1;
+    int output_height = height > 1 ? height / 2 : 1;
+    size_t stride = (size_t)width * components;
+    for (int y = 0; y < output_height; y++) {
+        const GLubyte* top = pixels + SDL_min(y * 2, height - 1) * stride;
+        const GLubyte* bottom = pixels + SDL_min(y * 2 + 1, height - 1) * stride;
+        GLubyte* row = output + (size_t)y * output_width * components;
+        int x = 0;
+#ifdef TEXTURE_SSE2
+        if (components == 4 && width > 1) {
+            __m128i zero = _mm_setzero_si128();
+            __m128i rounding = _mm_set1_epi16(2);
+            // two RGBA output pixels from four input pixels of both rows
+            for (; x + 2 <= output_width; x += 2) {
+                __m128i upper = _mm_loadu_si128((const __m128i*)(top + x * 8));
+                __m128i lower = _mm_loadu_si128((const __m128i*)(bottom + x * 8));
+                __m128i left = _mm_add_epi16(_mm_unpacklo_epi8(upper, zero), _mm_unpacklo_epi8(lower, zero));
+                __m128i right = _mm_add_epi16(_mm_unpackhi_epi8(upper, zero), _mm_unpackhi_epi8(lower, zero));
+                __m128i sum;
+                left = _mm_add_epi16(left, _mm_srli_si128(left, 8));
+                right = _mm_add_epi16(right, _mm_srli_si128(right, 8));
+                sum = _mm_srli_epi16(_mm_add_epi16(_mm_unpacklo_epi64(left, right), rounding), 2);
+                _mm_storel_epi64((__m128i*)(row + x * 4), _mm_packus_epi16(sum, sum));
+            }
+        }
+#endif
+        for (; x < output_width; x++) {
+            int x0 = SDL_min(x * 2, width - 1) * components;
+            int x1 = SDL_min(x * 2 + 1, width - 1) * components;
+            for (int c = 0; c < components; c++) {
+                row[x * components + c] = (GLubyte)((top[x0 + c] + top[x1 + c] + bottom[x0 + c] + bottom[x1 + c] + 2) >> 2);
+            }
+        }
+    }
+}
+
+// Uploads every mipmap level below the full image, for contexts without
+// glGenerateMipmap. Levels are built from each other in two scratch buffers.
+static int
+Texture_BuildMipmaps(const GLubyte* pixels, int width, int height, int components, GLenum format) {
+    size_t size = (size_t)(width > 1 ? width / 2 : 1) * (height > 1 ? height / 2 : 1) * components;
+    GLubyte* buffers[2];
+    int level = 0;
+    buffers[0] = (GLubyte*)malloc(size);
+    buffers[1] = (GLubyte*)malloc(size);
+    if (buffers[0] == NULL || buffers[1] == NULL) {
+        free(buffers[0]);
+        free(buffers[1]);
+        PyErr_NoMemory();
+        return -1;
+    }
+    while (width > 1 || height > 1) {
+        GLubyte* output = buffers[level % 2];
+        Texture_Downsample(pixels, width, height, components, output);
+        width = width > 1 ? width / 2 : 1;
+        height = height > 1 ? height / 2 : 1;
+        level++;
+        glTexImage2D(GL_TEXTURE_2D, level, format, width, height, 0, format, GL_UNSIGNED_BYTE, output);
+        pixels = output;
+    }
+    free(buffers[0]);
+    free(buffers[1]);
+    return 0;
+}
+
+// Rebuilds the mipmaps of the bound texture after its pixels changed.
+// Without glGenerateMipmap that needs the whole image, so a partial
+// update turns mipmapping off instead.
+static int
+Texture_GenerateMipmaps(Texture* self, const GLubyte* pixels, int width, int height, int components, GLenum format) {
+    if (! self->mipmaps) {
+        return 0;
+    }
+    if (OpenGL_HasFramebuffers) {
+        glGenerateMipmap(GL_TEXTURE_2D);
+        return 0;
+    }
+    if (pixels != NULL && width == self->width && height == self->height) {
+        return Texture_BuildMipmaps(pixels, width, height, components, format);
+    }
+    self->mipmaps = 0;
+    Texture_SetParameters(self);
+    return 0;
+}
+
+static int
+Texture_init(Texture* self, PyObject* args, PyObject* kwargs) {
+    PyObject* renderer;
+    Py_buffer data;
+    GLenum filter = GL_NEAREST, wrap = GL_CLAMP_TO_EDGE;
+    GLenum format;
+    int width, height, components, mipmaps = 0, coverage = 0;
+    if (! PyArg_ParseTuple(args, "O!y*iii|IIpp", &RendererType, &renderer, &data, &width, &height, &components, &filter, &wrap, &mipmaps, &coverage)) {
+        return -1;
+    }
+    if (components != 1 && components != 3 && components != 4) {
+        PyBuffer_Release(&data);
+        PyErr_SetString(PyExc_ValueError, "images must have 1, 3 or 4 components");
+        return -1;
+    }
+    if (width < 0 || height < 0 || data.len < (Py_ssize_t)width * height * components) {
+        PyBuffer_Release(&data);
+        PyErr_SetString(PyExc_ValueError, "image pixels don't match its size");
+        return -1;
+    }
+    if (filter != GL_NEAREST && filter != GL_LINEAR) {
+        PyBuffer_Release(&data);
+        PyErr_SetString(PyExc_ValueError, "texture filter must be NEAREST or LINEAR");
+        return -1;
+    }
+    if (wrap != GL_CLAMP_TO_EDGE && wrap != GL_REPEAT && wrap != GL_MIRRORED_REPEAT) {
+        PyBuffer_Release(&data);
+        PyErr_SetString(PyExc_ValueError, "texture wrap must be CLAMP_TO_EDGE, REPEAT or MIRRORED_REPEAT");
+        return -1;
+    }
+    if (self->renderer != NULL) {
+        PyBuffer_Release(&data);
+        PyErr_SetString(PyExc_RuntimeError, "texture is already initialized");
+        return -1;
+    }
+    if (Renderer_MakeCurrent((Renderer*)renderer) != 0) {
+        PyBuffer_Release(&data);
+        return -1;
+    }
+    self->renderer = (Renderer*)renderer;
+    Py_INCREF(self->renderer);
+    self->filter = filter;
+    self->wrap = wrap;
+    self->mipmaps = mipmaps;
+    self->coverage = coverage;
+    self->width = self->image_width = width;
+    self->height = self->image_height = height;
+    format = Texture_Format(self, components);
+
+    glGenTextures(1, &self->id);
+    GLState_BindTexture(&self->renderer->gl, self->id);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    Texture_Allocate(self, format, data.buf);
+    if (Texture_GenerateMipmaps(self, (const GLubyte*)data.buf, width, height, components, format) != 0) {
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        PyBuffer_Release(&data);
+        return -1;
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    PyBuffer_Release(&data);
+    Texture_SetParameters(self);
+    return 0;
+}
+
+static int
+Texture_traverse(Texture* self, visitproc visit, void* arg) {
+    Py_VISIT(self->renderer);
+    return 0;
+}
+
+// Also breaks reference cycles, e.g. through a texture cache of the renderer.
+static int
+Texture_clear(Texture* self) {
+    if (self->id != 0 && self->renderer != NULL) {
+        Renderer_DeleteTexture(self->renderer, self->id);
+    }
+    self->id = 0;
+    Py_CLEAR(self->renderer);
+    return 0;
+}
+
+static void
+Texture_dealloc(Texture* self) {
+    PyObject_GC_UnTrack(self);
+    Texture_clear(self);
+    Py_TYPE(self)->tp_free((PyObject*)self);
+}
+
+static PyObject*
+Texture__update(Texture* self, PyObject* args) {
+    Py_buffer data;
+    GLenum format;
+    int width, height, components, x, y;
+    if (! PyArg_ParseTuple(args, "y*iiiii", &data, &width, &height, &components, &x, &y)) {
+        return NULL;
+    }
+    if (components != 1 && components != 3 && components != 4) {
+        PyBuffer_Release(&data);
+        PyErr_SetString(PyExc_ValueError, "images must have 1, 3 or 4 components");
+        return NULL;
+    }
+    if (width < 0 || height < 0 || data.len < (Py_ssize_t)width * height * components) {
+        PyBuffer_Release(&data);
+        PyErr_SetString(PyExc_ValueError, "image pixels don't match its size");
+        return NULL;
+    }
+    if (x < 0 || y < 0) {
+        PyBuffer_Release(&data);
+        PyErr_SetString(PyExc_ValueError, "texture offset must not be negative");
+        return NULL;
+    }
+    if (self->id == 0) {
+        PyBuffer_Release(&data);
+        PyErr_SetString(PyExc_RuntimeError, "texture is not initialized");
+        return NULL;
+    }
+    format = Texture_Format(self, components);
+
+    // batched draws still sample the old pixels
+    if (Renderer_Flush(self->renderer) != 0) {
+        PyBuffer_Release(&data);
+        return NULL;
+    }
+    GLState_BindTexture(&self->renderer->gl, self->id);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    // storage only ever grows, so shrinking images reuse it, but images
+    // of another format start it over
+    if (x + width > self->width || y + height > self->height || format != self->format) {
+        self->width = SDL_max(self->width, x + width);
+        self->height = SDL_max(self->height, y + height);
+        Texture_Allocate(self, format, NULL);
+    }
+    glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, width, height, format, GL_UNSIGNED_BYTE, data.buf);
+    if (Texture_GenerateMipmaps(self, x == 0 && y == 0 ? (const GLubyte*)data.buf : NULL, width, height, components, format) != 0) {
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        PyBuffer_Release(&data);
+        return NULL;
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    PyBuffer_Release(&data);
+
+    // an image at the origin replaces what the texture shows, others extend it
+    if (x == 0 && y == 0) {
+        self->image_width = width;
+        self->image_height = height;
+    }
+    else {
+        self->image_width = SDL_max(self->image_width, x + width);
+        self->image_height = SDL_max(self->image_height, y + height);
+    }
+    Py_RETURN_NONE;
+}
+
+static PyObject*
+Texture_get_id(Texture* self, void* closure) {
+    return PyLong_FromUnsignedLong(self->id);
+}
+
+static PyObject*
+Texture_get_width(Texture* self, void* closure) {
+    return PyLong_FromLong(self->width);
+}
+
+static PyObject*
+Texture_get_height(Texture* self, void* closure) {
+    return PyLong_FromLong(self->height);
+}
+
+static PyObject*
+Texture_get_image_width(Texture* self, void* closure) {
+    return PyLong_FromLong(self->image_width);
+}
+
+static PyObject*
+Texture_get_image_height(Texture* self, void* closure) {
+    return PyLong_FromLong(self->image_height);
+}
+
+static PyObject*
+Texture_get_filter(Texture* self, void* closure) {
+    return PyLong_FromUnsignedLong(self->filter);
+}
+
+static PyObject*
+Texture_get_wrap(Texture* self, void* closure) {
+    return PyLong_FromUnsignedLong(self->wrap);
+}
+
+static PyObject*
+Texture_get_components(Texture* self, void* closure) {
+    if (self->format == GL_RGBA) {
+        return PyLong_FromLong(4);
+    }
+    return PyLong_FromLong(self->format == GL_RGB ? 3 : 1);
+}
+
+static PyObject*
+Texture_get_coverage(Texture* self, void* closure) {
+    return PyBool_FromLong(self->coverage);
+}
+
+static PyObject*
+Texture_get_mipmaps(Texture* self, void* closure) {
+    return PyBool_FromLong(self->mipmaps);
+}
+
+static PyGetSetDef Texture_getsetters[] = {
+    {
+        "id",
+        (getter)Texture_get_id,
+        NULL,
+        "OpenGL name of the texture.",
+        NULL
+    },
+    {
+        "width",
+        (getter)Texture_get_width,
+        NULL,
+        "Width of the texture storage, in pixels.",
+        NULL
+    },
+    {
+        "height",
+        (getter)Texture_get_height,
+        NULL,
+        "Height of the texture storage, in pixels.",
+        NULL
+    },
+    {
+        "image_width",
+        (getter)Texture_get_image_width,
+        NULL,
+        "Width of the image shown by the texture, in pixels.",
+        NULL
+    },
+    {
+        "image_height",
+        (getter)Texture_get_image_height,
+        NULL,
+        "Height of the image shown by the texture, in pixels.",
+        NULL
+    },
+    {
+        "filter",
+        (getter)Texture_get_filter,
+        NULL,
+        "Sampling filter, NEAREST or LINEAR.",
+        NULL
+    },
+    {
+        "wrap",
+        (getter)Texture_get_wrap,
+        NULL,
+        "Sampling outside the texture, CLAMP_TO_EDGE, REPEAT or MIRRORED_REPEAT.",
+        NULL
+    },
+    {
+        "components",
+        (getter)Texture_get_components,
+        NULL,
+        "Number of components of the image last uploaded to the storage, 1, 3 or 4.",
+        NULL
+    },
+    {
+        "coverage",
+        (getter)Texture_get_coverage,
+        NULL,
+        "Whether single component images are glyph coverage rather than luminance.",
+        NULL
+    },
+    {
+        "mipmaps",
+        (getter)Texture_get_mipmaps,
+        NULL,
+        "Whether minified drawing samples mipmaps.",
+        NULL
+    },
+    {NULL}
+};
+
+static PyMethodDef Texture_methods[] = {
+    {
+        "_update",
+        (PyCFunction)Texture__update,
+        METH_VARARGS,
+        "..."
+    },
+    {NULL}
+};
+
+PyTypeObject TextureType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "wutu._graphics.Texture",
+    sizeof(Texture),
+    0,                         /* tp_itemsize */
+    (destructor)Texture_dealloc,
+    0,                         /* tp_print */
+    0,                         /* tp_getattr */
+    0,                         /* tp_setattr */
+    0,                         /* tp_reserved */
+    0,                         /* tp_repr */
+    0,                         /* tp_as_number */
+    0,                         /* tp_as_sequence */
+    0,                         /* tp_as_mapping */
+    0,                         /* tp_hash  */
+    0,                         /* tp_call */
+    0,                         /* tp_str */
+    0,                         /* tp_getattro */
+    0,                         /* tp_setattro */
+    0,                         /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE | Py_TPFLAGS_HAVE_GC,
+    "OpenGL texture of a rendering context.",
+    (traverseproc)Texture_traverse,
+    (inquiry)Texture_clear,
+    0,                         /* tp_richcompare */
+    0,                         /* tp_weaklistoffset */
+    0,                         /* tp_iter */
+    0,                         /* tp_iternext */
+    Texture_methods,
+    0,                         /* tp_members */
+    Texture_getsetters,
+    0,
+    0,                         /* tp_dict */
+    0,                         /* tp_descr_get */
+    0,                         /* tp_descr_set */
+    0,                         /* tp_dictoffset */
+    (initproc)Texture_init,
+    0,                         /* tp_alloc */
+    (newfunc)PyType_GenericNew
+};
@@ -0,0 +1,36 @@
+#ifndef TEXTURE_H
+#define TEXTURE_H
+
+#include <Python.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_opengl.h>
+
+#include "renderer.h"
+
+// OpenGL texture owned by a renderer, deleted on its context once the
+// last reference is gone. The storage (width, height) may be larger than
+// the image currently shown (image_width, image_height). Single component
+// images are luminance, or glyph coverage when coverage is set.
+typedef struct {
+    PyObject_HEAD
+    Renderer* renderer;
+    GLuint id;
+    int width;
+    int height;
+    int image_width;
+    int image_height;
+    GLenum filter;
+    GLenum wrap;
+    int mipmaps;
+    int coverage;
+    GLenum format;
+} Texture;
+
+extern PyTypeObject TextureType;
+
+#endif /* TEXTURE_H */
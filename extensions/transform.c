@@ -0,0 +1,144 @@
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "transform.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define TRANSFORM_SSE2
+#endif
+
+#define TRANSFORM_PI 3.14159265358979323846
+
+void
+Transform_Identity(Transform* transform) {
+    transform->a = 1.0f;
+    transform->b = 0.0f;
+    transform->c = 0.0f;
+    transform->d = 1.0f;
+    transform->x = 0.0f;
+    transform->y = 0.0f;
+}
+
+int
+Transform_IsIdentity(const Transform* transform) {
+    return transform->a == 1.0f && transform->b == 0.0f
+        && transform->c == 0.0f && transform->d == 1.0f
+        && transform->x == 0.0f && transform->y == 0.0f;
+}
+
+void
+Transform_Translate(Transform* transform, GLfloat x, GLfloat y) {
+    transform->x += transform->a * x + transform->c * y;
+    transform->y += transform->b * x + transform->d * y;
+}
+
+// Same convention as glRotatef around the z axis, angle in degrees.
+void
+Transform_Rotate(Transform* transform, GLfloat angle) {
+    double radians = angle * TRANSFORM_PI / 180.0;
+    GLfloat cosine = (GLfloat)cos(radians);
+    GLfloat sine = (GLfloat)sin(radians);
+    GLfloat a = transform->a, b = transform->b;
+    transform->a = a * cosine + transform->c * sine;
+    transform->b = b * cosine + transform->d * sine;
+    transform->c = transform->c * cosine - a * sine;
+    transform->d = transform->d * cosine - b * sine;
+}
+
+void
+Transform_Scale(Transform* transform, GLfloat x, GLfloat y) {
+    transform->a *= x;
+    transform->b *= x;
+    transform->c *= y;
+    transform->d *= y;
+}
+
+// Column major, as glLoadMatrixf expects.
+void
+Transform_ToMatrix(const Transform* transform, GLfloat* matrix) {
+    memset(matrix, 0, 16 * sizeof(GLfloat));
+    matrix[0] = transform->a;
+    matrix[1] = transform->b;
+    matrix[4] = transform->c;
+    matrix[5] = transform->d;
+    matrix[10] = 1.0f;
+    matrix[12] = transform->x;
+    matrix[13] = transform->y;
+    matrix[15] = 1.0f;
+}
+
+void
+Transform_Points(const Transform* transform, const GLfloat* points, GLfloat* output, int count) {
+    int i = 0;
+#ifdef TRANSFORM_SSE2
+    // two points per register: (x0, y0, x1, y1)
+    __m128 ab = _mm_setr_ps(transform->a, transform->b, transform->a, transform->b);
+    __m128 cd = _mm_setr_ps(transform->c, transform->d, transform->c, transform->d);
+    __m128 xy = _mm_setr_ps(transform->x, transform->y, transform->x, transform->y);
+    for (; i + 2 <= count; i += 2) {
+        __m128 point = _mm_loadu_ps(points + i * 2);
+        __m128 xx = _mm_shuffle_ps(point, point, _MM_SHUFFLE(2, 2, 0, 0));
+        __m128 yy = _mm_shuffle_ps(point, point, _MM_SHUFFLE(3, 3, 1, 1));
+        _mm_storeu_ps(output + i * 2, _mm_add_ps(_mm_add_ps(_mm_mul_ps(xx, ab), _mm_mul_ps(yy, cd)), xy));
+    }
+#endif
+    for (; i < count; i++) {
+        GLfloat x = points[i * 2];
+        GLfloat y = points[i * 2 + 1];
+        output[i * 2] = transform->a * x + transform->c * y + transform->x;
+        output[i * 2 + 1] = transform->b * x + transform->d * y + transform->y;
+    }
+}
+
+int
+TransformStack_Init(TransformStack* stack) {
+    stack->transforms = (Transform*)malloc(TRANSFORM_INITIAL_CAPACITY * sizeof(Transform));
+    if (stack->transforms == NULL) {
+        stack->depth = 0;
+        stack->capacity = 0;
+        return -1;
+    }
+    stack->depth = 1;
+    stack->capacity = TRANSFORM_INITIAL_CAPACITY;
+    Transform_Identity(stack->transforms);
+    return 0;
+}
+
+void
+TransformStack_Free(TransformStack* stack) {
+    free(stack->transforms);
+    stack->transforms = NULL;
+    stack->depth = 0;
+    stack->capacity = 0;
+}
+
+Transform*
+TransformStack_Top(TransformStack* stack) {
+    return &stack->transforms[stack->depth - 1];
+}
+
+int
+TransformStack_Push(TransformStack* stack) {
+    if (stack->depth == stack->capacity) {
+        Transform* transforms = (Transform*)realloc(stack->transforms, stack->capacity * 2 * sizeof(Transform));
+        if (transforms == NULL) {
+            return -1;
+        }
+        stack->transforms = transforms;
+        stack->capacity *= 2;
+    }
+    stack->transforms[stack->depth] = stack->transforms[stack->depth - 1];
+    stack->depth++;
+    return 0;
+}
+
+int
+TransformStack_Pop(TransformStack* stack) {
+    if (stack->depth <= 1) {
+        return -1;
+    }
+    stack->depth--;
+    return 0;
+}
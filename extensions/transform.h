@@ -0,0 +1,64 @@
+#ifndef TRANSFORM_H
+#define TRANSFORM_H
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_opengl.h>
+
+#define TRANSFORM_INITIAL_CAPACITY 32
+
+// 2D affine matrix: x' = a * x + c * y + x, y' = b * x + d * y + y.
+typedef struct {
+    GLfloat a, b;
+    GLfloat c, d;
+    GLfloat x, y;
+} Transform;
+
+// Counterpart of the fixed function modelview stack, kept on the CPU.
+typedef struct {
+    Transform* transforms;
+    int depth;
+    int capacity;
+} TransformStack;
+
+void
+Transform_Identity(Transform* transform);
+
+int
+Transform_IsIdentity(const Transform* transform);
+
+void
+Transform_Translate(Transform* transform, GLfloat x, GLfloat y);
+
+void
+Transform_Rotate(Transform* transform, GLfloat angle);
+
+void
+Transform_Scale(Transform* transform, GLfloat x, GLfloat y);
+
+void
+Transform_ToMatrix(const Transform* transform, GLfloat* matrix);
+
+// Transforms count interleaved (x, y) points, output may alias input.
+void
+Transform_Points(const Transform* transform, const GLfloat* points, GLfloat* output, int count);
+
+int
+TransformStack_Init(TransformStack* stack);
+
+void
+TransformStack_Free(TransformStack* stack);
+
+Transform*
+TransformStack_Top(TransformStack* stack);
+
+int
+TransformStack_Push(TransformStack* stack);
+
+int
+TransformStack_Pop(TransformStack* stack);
+
+#endif /* TRANSFORM_H */
@@ -0,0 +1,201 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "triangulate.h"
+
+// Twice the signed area of triangle (a, b, c), positive when it turns the
+// same way as a polygon with positive area.
+static double
+Triangulate_Cross(const GLfloat* points, int a, int b, int c) {
+    double ax = points[a * 2], ay = points[a * 2 + 1];
+    double bx = points[b * 2], by = points[b * 2 + 1];
+    double cx = points[c * 2], cy = points[c * 2 + 1];
+    return (bx - ax) * (cy - ay) - (by - ay) * (cx - ax);
+}
+
+static double
+Triangulate_Area(const GLfloat* points, int count) {
+    double area = 0.0;
+    for (int i = 0, j = count - 1; i < count; j = i++) {
+        area += (double)points[j * 2] * points[i * 2 + 1] - (double)points[i * 2] * points[j * 2 + 1];
+    }
+    return area;
+}
+
+int
+Triangulate_IsConvex(const GLfloat* points, int count) {
+    int sign = 0;
+    for (int i = 0; i < count; i++) {
+        double cross = Triangulate_Cross(points, (i + count - 1) % count, i, (i + 1) % count);
+        if (cross == 0.0) {
+            continue;
+        }
+        if (sign == 0) {
+            sign = cross > 0.0 ? 1 : -1;
+        }
+        else if ((cross > 0.0) != (sign > 0)) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static int
+Triangulate_Contains(const GLfloat* points, int a, int b, int c, int p, double orientation) {
+    return Triangulate_Cross(points, a, b, p) * orientation >= 0.0
+        && Triangulate_Cross(points, b, c, p) * orientation >= 0.0
+        && Triangulate_Cross(points, c, a, p) * orientation >= 0.0;
+}
+
+// An ear is a convex corner whose triangle holds no reflex vertex, only
+// those can poke into it.
+static int
+Triangulate_IsEar(const GLfloat* points, const int* next, const int* previous, const char* reflex, int i, double orientation) {
+    int a = previous[i], c = next[i];
+    if (reflex[i]) {
+        return 0;
+    }
+    for (int p = next[c]; p != a; p = next[p]) {
+        if (reflex[p] && Triangulate_Contains(points, a, i, c, p, orientation)) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+int
+Triangulate_Polygon(const GLfloat* points, int count, GLuint* indices) {
+    int* links;
+    int* next;
+    int* previous;
+    char* reflex;
+    double orientation;
+    int length = 0, remaining = count, i = 0, attempts = 0;
+    if (count < 3) {
+        return 0;
+    }
+    links = (int*)malloc(count * 2 * sizeof(int));
+    reflex = (char*)malloc(count);
+    if (links == NULL || reflex == NULL) {
+        free(links);
+        free(reflex);
+        return -1;
+    }
+    next = links;
+    previous = links + count;
+    orientation = Triangulate_Area(points, count) < 0.0 ? -1.0 : 1.0;
+    for (int k = 0; k < count; k++) {
+        next[k] = (k + 1) % count;
+        previous[k] = (k + count - 1) % count;
+    }
+    for (int k = 0; k < count; k++) {
+        reflex[k] = Triangulate_Cross(points, previous[k], k, next[k]) * orientation <= 0.0;
+    }
+    while (remaining > 3) {
+        int a = previous[i], c = next[i];
+        // without any ear left the polygon intersects itself, cut anyway
+        if (Triangulate_IsEar(points, next, previous, reflex, i, orientation) || attempts++ > remaining) {
+            indices[length++] = a;
+            indices[length++] = i;
+            indices[length++] = c;
+            next[a] = c;
+            previous[c] = a;
+            remaining--;
+            reflex[a] = Triangulate_Cross(points, previous[a], a, c) * orientation <= 0.0;
+            reflex[c] = Triangulate_Cross(points, a, c, next[c]) * orientation <= 0.0;
+            attempts = 0;
+            i = a;
+        }
+        else {
+            i = c;
+        }
+    }
+    indices[length++] = previous[i];
+    indices[length++] = i;
+    indices[length++] = next[i];
+    free(links);
+    free(reflex);
+    return length;
+}
+
+void
+TriangulationCache_Init(TriangulationCache* cache) {
+    memset(cache, 0, sizeof(TriangulationCache));
+}
+
+void
+TriangulationCache_Free(TriangulationCache* cache) {
+    for (int i = 0; i < TRIANGULATE_CACHE_SIZE; i++) {
+        free(cache->entries[i].points);
+        free(cache->entries[i].indices);
+    }
+    free(cache->fan);
+    memset(cache, 0, sizeof(TriangulationCache));
+}
+
+// FNV-1a over the raw point data.
+static Uint64
+TriangulationCache_Key(const GLfloat* points, int count) {
+    const unsigned char* bytes = (const unsigned char*)points;
+    size_t size = (size_t)count * 2 * sizeof(GLfloat);
+    Uint64 key = 14695981039346656037ULL;
+    for (size_t i = 0; i < size; i++) {
+        key = (key ^ bytes[i]) * 1099511628211ULL;
+    }
+    return key;
+}
+
+const GLuint*
+TriangulationCache_Get(TriangulationCache* cache, const GLfloat* points, int count, int* length) {
+    TriangulationEntry* entry;
+    GLuint* indices;
+    GLfloat* copy;
+    Uint64 key;
+    size_t bytes = (size_t)count * 2 * sizeof(GLfloat);
+    int size = count > 2 ? (count - 2) * 3 : 0;
+    if (Triangulate_IsConvex(points, count)) {
+        if (size > cache->fan_capacity) {
+            indices = (GLuint*)realloc(cache->fan, size * sizeof(GLuint));
+            if (indices == NULL) {
+                return NULL;
+            }
+            cache->fan = indices;
+            cache->fan_capacity = size;
+        }
+        for (int i = 0; i < size / 3; i++) {
+            cache->fan[i * 3] = 0;
+            cache->fan[i * 3 + 1] = i + 1;
+            cache->fan[i * 3 + 2] = i + 2;
+        }
+        *length = size;
+        return cache->fan;
+    }
+    key = TriangulationCache_Key(points, count);
+    entry = &cache->entries[key % TRIANGULATE_CACHE_SIZE];
+    if (entry->indices != NULL && entry->key == key && entry->count == count && memcmp(entry->points, points, bytes) == 0) {
+        *length = entry->length;
+        return entry->indices;
+    }
+    indices = (GLuint*)malloc(size * sizeof(GLuint));
+    copy = (GLfloat*)malloc(bytes);
+    if (indices == NULL || copy == NULL) {
+        free(indices);
+        free(copy);
+        return NULL;
+    }
+    *length = Triangulate_Polygon(points, count, indices);
+    if (*length < 0) {
+        free(indices);
+        free(copy);
+        return NULL;
+    }
+    memcpy(copy, points, bytes);
+    free(entry->points);
+    free(entry->indices);
+    entry->key = key;
+    entry->count = count;
+    entry->points = copy;
+    entry->indices = indices;
+    entry->length = *length;
+    return indices;
+}
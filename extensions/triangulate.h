@@ -0,0 +1,51 @@
+#ifndef TRIANGULATE_H
+#define TRIANGULATE_H
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_opengl.h>
+
+#define TRIANGULATE_CACHE_SIZE 64
+
+// Triangles of a concave polygon, looked up by a hash of its points.
+typedef struct {
+    Uint64 key;
+    int count;
+    // a copy of the polygon, as hashes alone may collide
+    GLfloat* points;
+    GLuint* indices;
+    int length;
+} TriangulationEntry;
+
+// Direct-mapped cache of concave polygon triangulations. Convex polygons
+// are fanned in linear time into a scratch array instead.
+typedef struct {
+    TriangulationEntry entries[TRIANGULATE_CACHE_SIZE];
+    GLuint* fan;
+    int fan_capacity;
+} TriangulationCache;
+
+int
+Triangulate_IsConvex(const GLfloat* points, int count);
+
+// Writes up to (count - 2) * 3 triangle indices of a simple polygon by ear
+// clipping and returns their number, or -1 when out of memory.
+// Self-intersecting polygons still produce triangles, just not exact ones.
+int
+Triangulate_Polygon(const GLfloat* points, int count, GLuint* indices);
+
+void
+TriangulationCache_Init(TriangulationCache* cache);
+
+void
+TriangulationCache_Free(TriangulationCache* cache);
+
+// Returns triangle indices of count interleaved (x, y) points, valid until
+// the next call, or NULL when out of memory.
+const GLuint*
+TriangulationCache_Get(TriangulationCache* cache, const GLfloat* points, int count, int* length);
+
+#endif /* TRIANGULATE_H */
@@ -1,4 +1,5 @@
 #include "window.h"
+#include "renderer.h"
 
 static int
 Window_init(Window* self, PyObject* args, PyObject* kwargs) {
@@ -27,6 +28,9 @@ Window_dealloc(Window* self) {
 
 static PyObject*
 Window_update(Window* self) {
+    if (self->renderer != NULL && Renderer_Flush(self->renderer) != 0) {
+        return NULL;
+    }
     SDL_GL_SwapWindow(self->instance);
     Py_RETURN_NONE;
 }
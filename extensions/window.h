@@ -10,11 +10,14 @@
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_opengl.h>
 
+struct Renderer;
+
 typedef struct {
     PyObject_HEAD
     SDL_Window* instance;
     int width;
     int height;
+    struct Renderer* renderer;
 } Window;
 
 extern PyTypeObject WindowType;
@@ -15,6 +15,26 @@ LIB_DIRECTORIES = [
     '/usr/local/lib'
 ]
 
+GRAPHICS_LIBRARIES = [
+    'opengl32',
+    'glu32',
+    'SDL2',
+    'freetype2412'
+]
+
+GRAPHICS_MACROS = []
+
+if sys.platform.startswith('linux'):
+    INCLUDE_DIRECTORIES.append('/usr/include/freetype2')
+    GRAPHICS_LIBRARIES = [
+        'GL',
+        'EGL',
+        'SDL2',
+        'freetype'
+    ]
+    # headless offscreen rendering, e.g. with Mesa llvmpipe
+    GRAPHICS_MACROS.append(('WUTU_EGL', None))
+
 _events = setuptools.Extension(
     '_events',
     include_dirs=INCLUDE_DIRECTORIES,
@@ -32,15 +52,28 @@ _graphics = setuptools.Extension(
     '_graphics',
     include_dirs=INCLUDE_DIRECTORIES,
     library_dirs=LIB_DIRECTORIES,
-    libraries=[
-        'opengl32',
-        'glu32',
-        'SDL2',
-        'freetype2412'
-    ],
+    libraries=GRAPHICS_LIBRARIES,
+    define_macros=GRAPHICS_MACROS,
     sources=[
         'extensions/window.c',
+        'extensions/opengl.c',
+        'extensions/shader.c',
+        'extensions/coordinates.c',
+        'extensions/glstate.c',
+        'extensions/batch.c',
+        'extensions/queue.c',
+        'extensions/capture.c',
+        'extensions/transform.c',
+        'extensions/triangulate.c',
+        'extensions/polyline.c',
+        'extensions/circles.c',
         'extensions/renderer.c',
+        'extensions/offscreen.c',
+        'extensions/mesh.c',
+        'extensions/atlas.c',
+        'extensions/texture.c',
+        'extensions/commandlist.c',
+        'extensions/glyphs.c',
         'extensions/font.c',
         'extensions/_graphics.c'
     ],
@@ -1,3 +1,4 @@
+import array
 import os
 import unittest
 
@@ -25,6 +26,9 @@ class GraphicsTestCase(unittest.TestCase):
             actual.save(actual.source)
             raise AssertionError('{} != {}'.format(expected.source, actual.source))
 
+    def red(self, image, x, y):
+        return image.pixels[(y * image.width + x) * 3]
+
 
 class TestFont(GraphicsTestCase):
 
@@ -64,6 +68,40 @@ class TestFont(GraphicsTestCase):
         self.assertEqual(288, width)
         self.assertEqual(24, height)
 
+    def test_measure_text_after_reload(self):
+        fira = wutu.graphics.Font()
+        fira.load('data/assets/fonts/fira/FiraSans-Regular.ttf', 16)
+        # characters past the Basic Multilingual Plane are cached apart
+        width, _ = fira.measure_text('\U0001F600')
+        self.assertEqual((width * 64, 22), fira.measure_text('\U0001F600\U0001F601' * 32))
+        fira.load('data/assets/fonts/fira/FiraSans-Regular.ttf', 32)
+        self.assertGreater(fira.measure_text('Beautiful is better than ugly.')[0], 208)
+
+    def test_render_text_coverage(self):
+        terminus = wutu.graphics.Font()
+        terminus.load('data/assets/fonts/terminus/ter-u12n.pcf.gz', 12)
+        text = 'Flat is better than nested.'
+        rgba = terminus.render_text(text)
+        width, height = terminus.measure_text(text)
+        buffer = bytearray(width * height)
+        coverage = terminus.render_text(text, components=1, tight=True, buffer=buffer)
+        self.assertIs(buffer, coverage.pixels)
+        self.assertEqual((width, height, 1), (coverage.width, coverage.height, coverage.components))
+        for y in range(height):
+            self.assertEqual(rgba.pixels[y * rgba.width * 4 + 3:(y * rgba.width + width) * 4:4], buffer[y * width:(y + 1) * width])
+        with self.assertRaises(ValueError):
+            terminus.render_text(text, components=1, buffer=bytearray(width))
+
+    def test_render_negative_left_bearing(self):
+        fira = wutu.graphics.Font()
+        fira.load('data/assets/fonts/fira/FiraSans-Regular.ttf', 16)
+        _, line_height = fira.measure_text('.')
+        # j starts left of the pen, the column clipped off the image must
+        # not wrap around into the row above
+        image = fira.render_text('.\nj\nmmmmmmmm')
+        column = [image.pixels[(y * image.width + image.width - 1) * 4 + 3] for y in range(2 * line_height)]
+        self.assertEqual([0] * (2 * line_height), column)
+
     @provide_image('data/expected/test_render_multiline_text.png')
     def test_render_multiline_text(self, expected_image):
         fira = wutu.graphics.Font()
@@ -77,6 +115,13 @@ class TestFont(GraphicsTestCase):
         ]
         self.assertImageEqual(expected_image, fira.render_text('\n'.join(lines)))
 
+    @provide_image('data/expected/test_render_overlapping_glyphs.png')
+    def test_render_overlapping_glyphs(self, expected_image):
+        fira = wutu.graphics.Font()
+        fira.load('data/assets/fonts/fira/FiraSans-Regular.ttf', 16)
+        # the boxes of f and j reach into their neighbours, whose ink stays
+        self.assertImageEqual(expected_image, fira.render_text('ffj Tj Wj'))
+
     @provide_image('data/expected/test_render_multiline_text_monospaced.png')
     def test_render_multiline_text_monospaced(self, expected_image):
         terminus = wutu.graphics.Font()
@@ -93,18 +138,26 @@ class TestFont(GraphicsTestCase):
 
 class TestRenderer(GraphicsTestCase):
 
+    backend = wutu.graphics.BACKEND_LEGACY
+
     def setUp(self):
         self.window = wutu.graphics.Window(128, 128, visible=False)
 
+    def create_renderer(self, **kwargs):
+        try:
+            return wutu.graphics.Renderer(self.window, backend=self.backend, **kwargs)
+        except RuntimeError as exception:
+            self.skipTest(exception)
+
     @provide_image('data/expected/test_clear.png')
     def test_clear(self, expected):
-        renderer = wutu.graphics.Renderer(self.window)
+        renderer = self.create_renderer()
         renderer.clear('#7bc0fd')
         self.assertImageEqual(expected, renderer.present())
 
     @provide_image('data/expected/test_draw_polygon.png')
     def test_draw_polygon(self, expected):
-        renderer = wutu.graphics.Renderer(self.window)
+        renderer = self.create_renderer()
         renderer.clear('#777777')
         renderer.set_color('#f0ad4e')
         coordinates = (
@@ -117,17 +170,133 @@ class TestRenderer(GraphicsTestCase):
         renderer.draw_polygon(coordinates)
         self.assertImageEqual(expected, renderer.present())
 
+    def test_draw_concave_polygon(self):
+        chevron = (16, 16, 64, 48, 112, 16, 64, 112)
+        draws = (
+            lambda renderer: renderer.draw_polygon(chevron),
+            lambda renderer: renderer.draw_mesh(renderer.create_mesh(chevron)),
+            lambda renderer: renderer.draw_instances(renderer.create_mesh(chevron), (0, 0, 0, 1, 1, 1, 1, 1)),
+        )
+        for batching in (False, True):
+            for draw in draws:
+                renderer = self.create_renderer(batching=batching)
+                renderer.clear('#000000')
+                draw(renderer)
+                renderer.flush()
+                image = renderer.present()
+                # the notch between both arms stays empty
+                self.assertEqual(0, image.pixels[(32 * image.width + 64) * 3])
+                self.assertEqual(255, image.pixels[(80 * image.width + 64) * 3])
+
+    def test_draw_wide_lines(self):
+        renderer = self.create_renderer(batching=True)
+        renderer.clear('#000000')
+        renderer.set_color('#ff0000')
+        renderer.draw_polygon((0, 0, 8, 0, 8, 8, 0, 8))
+        renderer.draw_line_strip((16, 32, 112, 32), width=8)
+        renderer.draw_line_strip((16, 64, 112, 64), width=8, cap=wutu.graphics.CAP_SQUARE)
+        renderer.draw_line_strip((16, 96, 64, 96, 64, 120), width=8, join=wutu.graphics.JOIN_MITER)
+        renderer.flush()
+        # fills and extruded lines share one draw call
+        self.assertEqual(1, renderer.draw_calls)
+        image = renderer.present()
+        self.assertEqual((255, 255, 0), (self.red(image, 64, 29), self.red(image, 64, 34), self.red(image, 64, 37)))
+        self.assertEqual((0, 255), (self.red(image, 14, 32), self.red(image, 14, 64)))
+        self.assertEqual(255, self.red(image, 67, 93))
+
+    def test_draw_lines_unknown_join(self):
+        renderer = self.create_renderer()
+        with self.assertRaises(ValueError):
+            renderer.draw_line_strip((16, 32, 112, 32), width=8, join=-2)
+        with self.assertRaises(ValueError):
+            renderer.draw_line_strip((16, 32, 112, 32), width=8, cap=3)
+        with self.assertRaises(ValueError):
+            renderer.draw_line_loops((16, 32, 112, 32, 64, 64), (0,), width=8, join=-5)
+
+    def test_draw_wide_mesh_lines(self):
+        renderer = self.create_renderer()
+        mesh = renderer.create_mesh((16, 32, 112, 32))
+        renderer.clear('#000000')
+        renderer.set_color('#ff0000')
+        renderer.draw_mesh(mesh, wutu.graphics.LINES, width=8)
+        renderer.draw_instances(mesh, (0, 48, 0, 1, 1, 0, 0, 1), wutu.graphics.LINES, width=8)
+        image = renderer.present()
+        for y in (32, 80):
+            column = [image.pixels[((y + offset) * image.width + 64) * 3] for offset in (-3, 2, 5)]
+            self.assertEqual([255, 255, 0], column)
+
+    def test_draw_smooth_lines(self):
+        renderer = self.create_renderer(batching=True)
+        renderer.clear('#000000')
+        renderer.set_color('#ff0000')
+        renderer.draw_line_strip((16, 32.25, 112, 32.25), width=2, smooth=True)
+        mesh = renderer.create_mesh((32, 64, 96, 64, 96, 112, 32, 112))
+        renderer.draw_mesh(mesh, wutu.graphics.LINE_LOOP, smooth=True)
+        renderer.flush()
+        # anti-aliased in a single pass, batched with each other
+        self.assertEqual(1, renderer.draw_calls)
+        image = renderer.present()
+        above, center, below = self.red(image, 64, 31), self.red(image, 64, 32), self.red(image, 64, 33)
+        self.assertEqual(255, center)
+        self.assertTrue(0 < below < above < 255)
+        self.assertTrue(0 < self.red(image, 64, 64) < 255)
+        self.assertEqual(0, self.red(image, 64, 88))
+
     @provide_image('data/expected/test_draw_rectangle.png')
     def test_draw_rectangle(self, expected):
-        renderer = wutu.graphics.Renderer(self.window)
+        renderer = self.create_renderer()
         renderer.clear('#f7f7ef')
         renderer.set_color('#d9534f')
         renderer.draw_rectangle(10, 10, 80, 24)
         self.assertImageEqual(expected, renderer.present())
 
+    def test_draw_primitives(self):
+        renderer = self.create_renderer(batching=True)
+        renderer.clear('#000000')
+        renderer.set_color('#ff0000')
+        renderer.draw_rectangles(array.array('f', (8, 8, 16, 16, 40, 8, 16, 16)))
+        renderer.draw_rectangles((72.5, 8.5, 16, 16), fill=False)
+        renderer.draw_circles(array.array('f', (16, 64, 8, 48, 64, 8)))
+        renderer.draw_circles((80, 64, 8), fill=False, width=2)
+        renderer.draw_line_loops((8.5, 96.5, 24.5, 96.5, 24.5, 112.5, 40.5, 96.5, 56.5, 96.5, 56.5, 112.5), (0, 3))
+        renderer.flush()
+        # fills and outlines, of every kind, cost a single draw call
+        self.assertEqual(1, renderer.draw_calls)
+        image = renderer.present()
+        self.assertEqual((255, 255, 0), (self.red(image, 16, 16), self.red(image, 48, 16), self.red(image, 32, 16)))
+        self.assertEqual((255, 0), (self.red(image, 72, 16), self.red(image, 80, 16)))
+        self.assertEqual((255, 255, 0), (self.red(image, 16, 64), self.red(image, 48, 70), self.red(image, 16, 74)))
+        self.assertEqual((255, 0), (self.red(image, 88, 64), self.red(image, 80, 64)))
+        self.assertEqual((255, 255, 0), (self.red(image, 24, 104), self.red(image, 56, 104), self.red(image, 32, 104)))
+        with self.assertRaises(ValueError):
+            renderer.draw_rectangles((0, 0, 8))
+        with self.assertRaises(ValueError):
+            renderer.draw_line_loops((0, 0, 8, 8), (1, 0))
+        for radius in (float('nan'), float('inf')):
+            with self.assertRaises(ValueError):
+                renderer.draw_circles((16, 16, radius))
+
+    def test_redundant_state_changes(self):
+        renderer = self.create_renderer()
+        renderer.clear('#000000')
+        renderer.set_color('#ff0000')
+        renderer.draw_polygon((0, 0, 8, 0, 8, 8))
+        issued, skipped = renderer.state_changes, renderer.skipped_state_changes
+        for i in range(10):
+            renderer.draw_polygon((0, 0, 8, 0, 8, 8))
+        # the same draw over and over sets nothing new
+        self.assertEqual(issued, renderer.state_changes)
+        self.assertGreater(renderer.skipped_state_changes, skipped)
+        renderer.set_color('#00ff00')
+        renderer.draw_line_strip((0, 16, 64, 16))
+        self.assertGreater(renderer.state_changes, issued)
+        image = renderer.present()
+        self.assertEqual((255, 0, 0), tuple(image.pixels[(2 * image.width + 4) * 3:(2 * image.width + 4) * 3 + 3]))
+        self.assertEqual((0, 255, 0), tuple(image.pixels[(16 * image.width + 32) * 3:(16 * image.width + 32) * 3 + 3]))
+
     @provide_image('data/expected/test_draw_line_loop.png')
     def test_draw_line_loop(self, expected):
-        renderer = wutu.graphics.Renderer(self.window)
+        renderer = self.create_renderer()
         renderer.clear('#777777')
         renderer.set_color('#f0ad4e')
         coordinates = (
@@ -142,7 +311,536 @@ class TestRenderer(GraphicsTestCase):
 
     @provide_image('data/expected/test_draw_texture.png')
     def test_draw_texture(self, expected):
-        renderer = wutu.graphics.Renderer(self.window)
+        renderer = self.create_renderer()
+        image = wutu.graphics.Image.load('data/assets/images/grid.png')
+        texture = renderer.create_texture(image)
+        renderer.draw_texture(texture)
+        self.assertImageEqual(expected, renderer.present())
+
+    @provide_image('data/expected/test_draw_texture.png')
+    def test_update_texture(self, expected):
+        renderer = self.create_renderer()
+        texture = renderer.create_texture(wutu.graphics.Image(bytes(16 * 16 * 4), 16, 16, 4))
+        image = wutu.graphics.Image.load('data/assets/images/grid.png')
+        renderer.update_texture(texture, image)
+        self.assertEqual((image.width, image.height), (texture.width, texture.height))
+        # smaller images reuse the storage
+        renderer.update_texture(texture, wutu.graphics.Image(bytes(8 * 8 * 4), 8, 8, 4))
+        self.assertEqual((image.width, image.height), (texture.width, texture.height))
+        self.assertEqual((8, 8), (texture.image_width, texture.image_height))
+        renderer.update_texture(texture, image)
+        renderer.draw_texture(texture)
+        self.assertImageEqual(expected, renderer.present())
+
+    def test_texture_mipmaps(self):
+        renderer = self.create_renderer()
+        # one pixel checkerboard, grey once minified
+        pixels = bytes(255 * ((x + y) % 2) for y in range(64) for x in range(64) for _ in range(3))
+        image = wutu.graphics.Image(pixels, 64, 64, 3)
+        texture = renderer.create_texture(image, mipmaps=True)
+        self.assertTrue(texture.mipmaps)
+        renderer._draw_textured_polygon((0, 0, 16, 0, 16, 16, 0, 16), (0, 0, 1, 0, 1, 1, 0, 1), texture)
+        result = renderer.present()
+        for y in range(16):
+            row = result.pixels[y * result.width * 3:(y * result.width + 16) * 3]
+            self.assertTrue(all(120 <= value <= 135 for value in row))
+
+    def test_texture_cache(self):
+        renderer = self.create_renderer()
+        path = 'data/assets/images/grid.png'
+        texture = renderer.load_texture(path)
+        self.assertIs(texture, renderer.load_texture(wutu.graphics.Image.load(path)))
+        image = wutu.graphics.Image(bytes(4 * 4 * 4), 4, 4, 4)
+        self.assertIs(renderer.load_texture(image), renderer.load_texture(image))
+        self.assertEqual(2, len(renderer.textures))
+        del image
+        self.assertEqual(1, len(renderer.textures))
+        # least recently used textures go first
+        renderer.textures.capacity = texture.width * texture.height * 4
+        renderer.load_texture(wutu.graphics.Image(bytes(4 * 4 * 4), 4, 4, 4, source='other'))
+        self.assertNotIn(path, renderer.textures)
+        self.assertIn('other', renderer.textures)
+
+    def test_texture_cache_counts_components(self):
+        renderer = self.create_renderer()
+        # room for one RGBA texture and four single component ones
+        renderer.textures.capacity = 2 * 16 * 16 * 4
+        rgba = wutu.graphics.Image(bytes(16 * 16 * 4), 16, 16, 4, source='rgba')
+        renderer.load_texture(rgba)
+        for i in range(4):
+            renderer.load_texture(wutu.graphics.Image(bytes(16 * 16), 16, 16, 1, source=str(i)))
+        self.assertEqual(16 * 16 * 4 * 2, renderer.textures.size)
+        self.assertEqual(5, len(renderer.textures))
+        renderer.load_texture(wutu.graphics.Image(bytes(16 * 16), 16, 16, 1, source='more'))
+        self.assertNotIn('rgba', renderer.textures)
+        self.assertEqual(5, len(renderer.textures))
+
+    @provide_image('data/expected/test_draw_polygon.png')
+    def test_draw_polygon_batched(self, expected):
+        renderer = self.create_renderer(batching=True)
+        renderer.clear('#777777')
+        renderer.set_color('#f0ad4e')
+        coordinates = (
+            32, 32,
+            32, 96,
+            64, 112,
+            96, 96,
+            96, 32,
+        )
+        renderer.draw_polygon(coordinates)
+        self.assertImageEqual(expected, renderer.present())
+
+    @provide_image('data/expected/test_draw_polygon.png')
+    def test_draw_polygon_from_buffer(self, expected):
+        coordinates = (32, 32, 32, 96, 64, 112, 96, 96, 96, 32)
+        renderer = self.create_renderer()
+        for typecode in 'fdhq':
+            for batching in (False, True):
+                renderer.batching = batching
+                renderer.clear('#777777')
+                renderer.set_color('#f0ad4e')
+                renderer.draw_polygon(memoryview(array.array(typecode, coordinates)))
+                self.assertImageEqual(expected, renderer.present())
+
+    @provide_image('data/expected/test_draw_polygon.png')
+    def test_draw_polygon_int16(self, expected):
+        coordinates = (32, 32, 32, 96, 64, 112, 96, 96, 96, 32)
+        renderer = self.create_renderer()
+        renderer.vertex_format = wutu.graphics.VERTEX_INT16
+        mesh = renderer.create_mesh(coordinates)
+        renderer.clear('#777777')
+        renderer.set_color('#f0ad4e')
+        renderer.draw_polygon(coordinates)
+        self.assertImageEqual(expected, renderer.present())
+        renderer.clear('#777777')
+        renderer.draw_mesh(mesh)
+        self.assertImageEqual(expected, renderer.present())
+
+    @provide_image('data/expected/test_draw_texture.png')
+    def test_draw_texture_unorm16(self, expected):
+        renderer = self.create_renderer()
+        renderer.texture_coordinate_format = wutu.graphics.VERTEX_UNORM16
+        image = wutu.graphics.Image.load('data/assets/images/grid.png')
+        texture = renderer.create_texture(image)
+        for batching in (False, True):
+            renderer.batching = batching
+            renderer.clear('#000000')
+            renderer.draw_texture(texture)
+            self.assertImageEqual(expected, renderer.present())
+
+    def test_draw_polygon_odd_coordinates(self):
+        renderer = self.create_renderer()
+        with self.assertRaises(ValueError):
+            renderer.draw_polygon(array.array('f', (32, 32, 32)))
+
+    def test_draw_polygon_invalid_coordinates(self):
+        renderer = self.create_renderer()
+        with self.assertRaises(TypeError):
+            renderer.draw_polygon((32, 32, 32, 'x', 64, 64))
+
+    @provide_image('data/expected/test_draw_texture.png')
+    def test_draw_texture_batched(self, expected):
+        renderer = self.create_renderer(batching=True)
+        image = wutu.graphics.Image.load('data/assets/images/grid.png')
+        texture = renderer.create_texture(image)
+        renderer.draw_texture(texture)
+        self.assertImageEqual(expected, renderer.present())
+
+    @provide_image('data/expected/test_draw_polygon.png')
+    def test_draw_mesh(self, expected):
+        renderer = self.create_renderer()
+        mesh = renderer.create_mesh((32, 32, 32, 96, 64, 112, 96, 96, 96, 32))
+        renderer.clear('#777777')
+        renderer.set_color('#f0ad4e')
+        renderer.draw_mesh(mesh, wutu.graphics.POLYGON)
+        self.assertEqual(5, mesh.length)
+        self.assertImageEqual(expected, renderer.present())
+
+    def test_draw_mesh_line_loop(self):
+        coordinates = (32, 32, 32, 96, 64, 112, 96, 96, 96, 32)
+        renderer = self.create_renderer()
+        renderer.clear('#777777')
+        renderer.set_color('#f0ad4e')
+        renderer.draw_line_loop(coordinates)
+        expected = renderer.present()
+        mesh = renderer.create_mesh(coordinates)
+        renderer.clear('#777777')
+        renderer.draw_mesh(mesh, wutu.graphics.LINE_LOOP)
+        self.assertEqual(expected.pixels, renderer.present().pixels)
+
+    @provide_image('data/expected/test_draw_polygon.png')
+    def test_draw_instances(self, expected):
+        renderer = self.create_renderer()
+        mesh = renderer.create_mesh((0, 0, 0, 64, 32, 80, 64, 64, 64, 0))
+        r, g, b, a = wutu.graphics.color_to_float_values('#f0ad4e')
+        transforms = array.array('f', (32, 32, 0, 1, r, g, b, a))
+        for instancing in {renderer.instancing, False}:
+            renderer.instancing = instancing
+            renderer.clear('#777777')
+            renderer.draw_instances(mesh, transforms)
+            self.assertImageEqual(expected, renderer.present())
+
+    def test_draw_instances_fallback(self):
+        renderer = self.create_renderer()
+        if not renderer.instancing:
+            self.skipTest('instanced drawing is not supported')
+        mesh = renderer.create_mesh((-4, -4, -4, 4, 4, 4, 4, -4))
+        transforms = []
+        for i in range(100):
+            transforms.extend((i % 10 * 12 + 8, i // 10 * 12 + 8, 90 * (i % 3), 1 + i % 2, i * 2 / 255, 1, 1, 1))
+        images = []
+        for instancing in (True, False):
+            renderer.instancing = instancing
+            renderer.clear('#000000')
+            calls = renderer.draw_calls
+            renderer.draw_instances(mesh, transforms)
+            renderer.draw_instances(mesh, transforms, wutu.graphics.LINE_LOOP)
+            renderer.draw_instances(mesh, transforms[:80], wutu.graphics.QUADS)
+            self.assertEqual(3, renderer.draw_calls - calls)
+            images.append(renderer.present())
+        self.assertEqual(images[0].pixels, images[1].pixels)
+
+    def test_batching_merges_draw_calls(self):
+        renderer = self.create_renderer(batching=True)
+        renderer.clear('#777777')
+        for offset in range(0, 100, 10):
+            renderer.set_color((offset / 100, 0.5, 0.5, 1.0))
+            renderer.draw_rectangle(offset, offset, 8, 8)
+            renderer.draw_line_strip((offset, 0, offset, 128))
+        renderer.flush()
+        self.assertEqual(20, renderer.draw_calls)
+        renderer.draw_rectangle(0, 0, 8, 8)
+        renderer.draw_rectangle(10, 10, 8, 8)
+        renderer.flush()
+        self.assertEqual(21, renderer.draw_calls)
+
+    def test_sorting_groups_draws(self):
+        renderer = self.create_renderer(batching=True)
+        renderer.clear('#000000')
+        textures = [
+            renderer.create_texture(wutu.graphics.Image(bytes((255, 0, 0, 255)) * 4, 2, 2, 4)),
+            renderer.create_texture(wutu.graphics.Image(bytes((0, 0, 255, 255)) * 4, 2, 2, 4)),
+        ]
+        renderer.sorting = True
+        for i in range(10):
+            renderer.draw_texture(textures[i % 2])
+        renderer.flush()
+        # one batch per texture instead of one per draw
+        self.assertEqual(2, renderer.draw_calls)
+        renderer.set_color('#00ff00')
+        renderer.layer = 1
+        renderer.draw_rectangle(0, 0, 8, 8)
+        renderer.layer = 0
+        renderer.set_color('#ff0000')
+        renderer.draw_rectangle(0, 0, 8, 8)
+        renderer.depth = 1
+        renderer.draw_line_strip((0, 16, 8, 16), width=4)
+        renderer.depth = 0
+        renderer.set_color('#0000ff')
+        renderer.draw_line_strip((0, 16, 8, 16), width=4)
+        image = renderer.present()
+        # higher layers and depths are drawn over lower ones, whatever the call order
+        self.assertEqual((0, 255, 0), tuple(image.pixels[(4 * image.width + 4) * 3:(4 * image.width + 4) * 3 + 3]))
+        self.assertEqual((255, 0, 0), tuple(image.pixels[(16 * image.width + 4) * 3:(16 * image.width + 4) * 3 + 3]))
+        with self.assertRaises(ValueError):
+            renderer.layer = 256
+
+    def test_sorting_survives_texture_deletes(self):
+        renderer = self.create_renderer(batching=True)
+        renderer.clear('#000000')
+        renderer.sorting = True
+        renderer.set_color('#00ff00')
+        renderer.layer = 1
+        renderer.draw_rectangle(0, 0, 8, 8)
+        # an unrelated texture going away mid-frame leaves the queue alone
+        texture = renderer.create_texture(wutu.graphics.Image(bytes(16), 2, 2, 4))
+        del texture
+        renderer.layer = 0
+        renderer.set_color('#ff0000')
+        renderer.draw_rectangle(0, 0, 8, 8)
+        image = renderer.present()
+        self.assertEqual((0, 255, 0), tuple(image.pixels[(4 * image.width + 4) * 3:(4 * image.width + 4) * 3 + 3]))
+
+    def test_draw_text(self):
+        terminus = wutu.graphics.Font()
+        terminus.load('data/assets/fonts/terminus/ter-u12n.pcf.gz', 12)
+        text = 'Readability counts.\nErrors should never pass silently.'
+        renderer = self.create_renderer()
+        renderer.clear('#000000')
+        renderer.draw_texture(renderer.create_texture(terminus.render_text(text)))
+        expected = renderer.present()
+        renderer = self.create_renderer(batching=True)
+        renderer.clear('#000000')
+        renderer.draw_text(terminus, text, color='#ffffff')
+        renderer.flush()
+        # every glyph comes from one atlas texture
+        self.assertEqual(1, renderer.draw_calls)
+        self.assertEqual(expected.pixels, renderer.present().pixels)
+        renderer.draw_text(terminus, text, 0, 100)
+        renderer.flush()
+        self.assertEqual(2, renderer.draw_calls)
+        with self.assertRaises(TypeError):
+            renderer.draw_text(terminus, text, color=(1.0, 1.0, 1.0))
+        # coverage textures are white tinted by the draw color, like glyphs
+        renderer = self.create_renderer()
+        renderer.clear('#000000')
+        renderer.draw_texture(renderer.create_texture(terminus.render_text(text, components=1)))
+        self.assertEqual(expected.pixels, renderer.present().pixels)
+
+    def test_draw_grayscale_texture(self):
+        renderer = self.create_renderer()
+        renderer.clear('#000000')
+        texture = renderer.create_texture(wutu.graphics.Image(bytes([128]) * 256, 16, 16, 1))
+        self.assertFalse(texture.coverage)
+        renderer.update_texture(texture, wutu.graphics.Image(bytes([64]) * 64, 8, 8, 1), 8, 8)
+        renderer.draw_texture(texture)
+        image = renderer.present()
+        pixel = lambda x, y: tuple(image.pixels[(y * image.width + x) * 3:(y * image.width + x) * 3 + 3])
+        self.assertEqual((128, 128, 128), pixel(4, 4))
+        self.assertEqual((64, 64, 64), pixel(12, 12))
+        with self.assertRaises(ValueError):
+            renderer.create_texture(wutu.graphics.Image(bytes(512), 16, 16, 2))
+        with self.assertRaises(ValueError):
+            renderer.update_texture(texture, wutu.graphics.Image(bytes(512), 16, 16, 2))
+
+    def test_replay_command_list(self):
+        renderer = self.create_renderer(batching=True)
+        renderer.clear('#000000')
+        renderer.translate(100, 100)
+        renderer.begin_recording()
+        renderer.set_color('#ff0000')
+        renderer.draw_rectangle(0, 0, 8, 8)
+        renderer.draw_line_strip((0, 16, 8, 16), width=4)
+        with self.assertRaises(RuntimeError):
+            renderer.restore()
+        commands = renderer.end_recording()
+        self.assertEqual(1, commands.commands)
+        renderer.flush()
+        # recording draws nothing
+        self.assertEqual(0, renderer.draw_calls)
+        renderer.replay(commands, (-100, -100, 0, 1))
+        renderer.replay(commands, (-60, -100, 0, 2))
+        renderer.flush()
+        self.assertEqual(1, renderer.draw_calls)
+        image = renderer.present()
+        pixel = lambda x, y: tuple(image.pixels[(y * image.width + x) * 3:(y * image.width + x) * 3 + 3])
+        self.assertEqual((255, 0, 0), pixel(4, 4))
+        self.assertEqual((255, 0, 0), pixel(4, 16))
+        self.assertEqual((255, 0, 0), pixel(54, 14))
+        self.assertEqual((0, 0, 0), pixel(20, 4))
+
+    @provide_image('data/expected/test_draw_texture.png')
+    def test_replay_keeps_textures(self, expected):
+        renderer = self.create_renderer()
+        texture = renderer.create_texture(wutu.graphics.Image.load('data/assets/images/grid.png'))
+        renderer.begin_recording()
+        renderer.draw_texture(texture)
+        commands = renderer.end_recording()
+        del texture
+        renderer.replay(commands)
+        self.assertImageEqual(expected, renderer.present())
+
+    @provide_image('data/expected/test_draw_texture.png')
+    def test_draw_texture_region(self, expected):
+        renderer = self.create_renderer()
+        image = wutu.graphics.Image.load('data/assets/images/grid.png')
+        atlas = renderer.create_atlas(256, 256)
+        region = atlas.add(image)
+        renderer.draw_texture_region(region)
+        self.assertImageEqual(expected, renderer.present())
+
+    def test_draw_texture_region_foreign_texture(self):
+        renderer = self.create_renderer()
+        atlas = renderer.create_atlas(256, 256)
+        region = atlas.add(wutu.graphics.Image.load('data/assets/images/grid.png'))
+        texture = renderer.create_texture(wutu.graphics.Image(bytes(16), 2, 2, 4))
+        for name in (texture.id, 12345):
+            region.texture = name
+            with self.assertRaises(ValueError):
+                renderer.draw_texture_region(region)
+
+    def test_atlas_packs_regions(self):
+        renderer = self.create_renderer(batching=True)
+        image = wutu.graphics.Image.load('data/assets/images/grid.png')
+        atlas = renderer.create_atlas(512, 512, padding=0)
+        regions = [atlas.add(image) for _ in range(4)]
+        self.assertEqual(1, atlas.pages)
+        positions = {(region.x, region.y) for region in regions}
+        self.assertEqual(4, len(positions))
+        for region in regions:
+            renderer.draw_texture_region(region, region.x / 4, region.y / 4, 32, 32)
+        renderer.flush()
+        self.assertEqual(1, renderer.draw_calls)
+        atlas.add(image)
+        self.assertEqual(2, atlas.pages)
+
+    def draw_transformed_polygon(self, renderer):
+        renderer.clear('#777777')
+        renderer.set_color('#f0ad4e')
+        renderer.save()
+        renderer.translate(64, 64)
+        renderer.rotate(180)
+        coordinates = (
+            32, 32,
+            32, -32,
+            0, -48,
+            -32, -32,
+            -32, 32,
+        )
+        renderer.draw_polygon(coordinates)
+        renderer.restore()
+
+    @provide_image('data/expected/test_draw_polygon.png')
+    def test_draw_polygon_transformed(self, expected):
+        renderer = self.create_renderer()
+        self.draw_transformed_polygon(renderer)
+        self.assertImageEqual(expected, renderer.present())
+
+    @provide_image('data/expected/test_draw_polygon.png')
+    def test_draw_polygon_transformed_batched(self, expected):
+        renderer = self.create_renderer(batching=True)
+        self.draw_transformed_polygon(renderer)
+        renderer.flush()
+        self.assertEqual(1, renderer.draw_calls)
+        self.assertImageEqual(expected, renderer.present())
+
+    def test_restore_without_save(self):
+        renderer = self.create_renderer()
+        with self.assertRaises(RuntimeError):
+            renderer.restore()
+
+    @provide_image('data/expected/test_draw_polygon.png')
+    def test_capture(self, expected):
+        renderer = self.create_renderer(batching=True)
+        self.assertIsNone(renderer.poll_capture())
+        renderer.clear('#777777')
+        renderer.set_color('#f0ad4e')
+        coordinates = (
+            32, 32,
+            32, 96,
+            64, 112,
+            96, 96,
+            96, 32,
+        )
+        renderer.draw_polygon(coordinates)
+        renderer.request_capture()
+        renderer.clear('#7bc0fd')
+        renderer.request_capture()
+        self.assertImageEqual(expected, renderer.poll_capture(wait=True))
+        self.assertEqual(renderer.present().pixels, renderer.poll_capture(wait=True).pixels)
+        self.assertIsNone(renderer.poll_capture(wait=True))
+
+
+class TestCoreRenderer(TestRenderer):
+
+    backend = wutu.graphics.BACKEND_CORE
+
+
+class TestOffscreenRenderer(GraphicsTestCase):
+
+    def create_renderer(self, **kwargs):
+        try:
+            return wutu.graphics.OffscreenRenderer(128, 128, **kwargs)
+        except RuntimeError as exception:
+            self.skipTest(exception)
+
+    @provide_image('data/expected/test_clear.png')
+    def test_clear(self, expected):
+        renderer = self.create_renderer()
+        renderer.clear('#7bc0fd')
+        self.assertImageEqual(expected, renderer.present())
+
+    @provide_image('data/expected/test_draw_polygon.png')
+    def test_draw_polygon(self, expected):
+        renderer = self.create_renderer(batching=True)
+        renderer.clear('#777777')
+        renderer.set_color('#f0ad4e')
+        coordinates = (
+            32, 32,
+            32, 96,
+            64, 112,
+            96, 96,
+            96, 32,
+        )
+        renderer.draw_polygon(coordinates)
+        self.assertImageEqual(expected, renderer.present())
+
+    @provide_image('data/expected/test_draw_polygon.png')
+    def test_draw_interleaved(self, expected):
+        renderer = self.create_renderer(batching=True)
+        other = self.create_renderer()
+        renderer.clear('#777777')
+        other.clear('#7bc0fd')
+        renderer.set_color('#f0ad4e')
+        renderer.draw_polygon((32, 32, 32, 96, 64, 112, 96, 96, 96, 32))
+        other.flush()
+        self.assertImageEqual(expected, renderer.present())
+
+    @provide_image('data/expected/test_draw_texture.png')
+    def test_update_texture_interleaved(self, expected):
+        renderer = self.create_renderer()
+        texture = renderer.create_texture(wutu.graphics.Image(bytes(16 * 16 * 4), 16, 16, 4))
+        other = self.create_renderer()
+        other.clear('#7bc0fd')
+        renderer.update_texture(texture, wutu.graphics.Image.load('data/assets/images/grid.png'))
+        other.flush()
+        renderer.draw_texture(texture)
+        self.assertImageEqual(expected, renderer.present())
+
+    @provide_image('data/expected/test_draw_texture.png')
+    def test_draw_texture_region_interleaved(self, expected):
+        renderer = self.create_renderer()
+        atlas = renderer.create_atlas(256, 256)
+        other = self.create_renderer()
+        other.clear('#7bc0fd')
+        region = atlas.add(wutu.graphics.Image.load('data/assets/images/grid.png'))
+        other.flush()
+        renderer.draw_texture_region(region)
+        self.assertImageEqual(expected, renderer.present())
+
+    @provide_image('data/expected/test_draw_polygon.png')
+    def test_draw_mesh_interleaved(self, expected):
+        renderer = self.create_renderer()
+        other = self.create_renderer()
+        other.create_mesh((0, 0, 8, 0, 8, 8))
+        mesh = renderer.create_mesh((32, 32, 32, 96, 64, 112, 96, 96, 96, 32))
+        other.clear('#7bc0fd')
+        renderer.clear('#777777')
+        renderer.set_color('#f0ad4e')
+        renderer.draw_mesh(mesh)
+        self.assertImageEqual(expected, renderer.present())
+
+    def test_draw_text_interleaved(self):
+        terminus = wutu.graphics.Font()
+        terminus.load('data/assets/fonts/terminus/ter-u12n.pcf.gz', 12)
+        renderer = self.create_renderer(batching=True)
+        other = self.create_renderer()
+        renderer.clear('#000000')
+        renderer.draw_text(terminus, 'Simple is better.', 0, 0, '#ffffff')
+        renderer.begin_recording()
+        renderer.draw_text(terminus, 'Simple is better.', 0, 64, '#ffffff')
+        commands = renderer.end_recording()
+        # drawing with another renderer replaces the font atlas, while the
+        # first one still has glyphs pending and recorded
+        other.draw_text(terminus, 'Complex is better than complicated.')
+        renderer.replay(commands)
+        image = renderer.present()
+        row = image.width * 3
+        self.assertTrue(any(image.pixels[:16 * row]))
+        self.assertEqual(image.pixels[:16 * row], image.pixels[64 * row:80 * row])
+
+    def test_replay_into_another_renderer(self):
+        renderer = self.create_renderer()
+        other = self.create_renderer()
+        renderer.begin_recording()
+        renderer.draw_rectangle(0, 0, 8, 8)
+        commands = renderer.end_recording()
+        with self.assertRaises(ValueError):
+            other.replay(commands)
+
+    @provide_image('data/expected/test_draw_texture.png')
+    def test_draw_texture_core(self, expected):
+        renderer = self.create_renderer(backend=wutu.graphics.BACKEND_CORE)
         image = wutu.graphics.Image.load('data/assets/images/grid.png')
         texture = renderer.create_texture(image)
         renderer.draw_texture(texture)
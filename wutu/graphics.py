@@ -1,6 +1,45 @@
+import collections
 import os
+import weakref
 from . import _graphics
 
+POINTS = 0x0000
+LINES = 0x0001
+LINE_LOOP = 0x0002
+LINE_STRIP = 0x0003
+TRIANGLES = 0x0004
+TRIANGLE_STRIP = 0x0005
+TRIANGLE_FAN = 0x0006
+QUADS = 0x0007
+QUAD_STRIP = 0x0008
+POLYGON = 0x0009
+
+VERTEX_FLOAT32 = 0
+VERTEX_INT16 = 1
+VERTEX_UNORM16 = 2
+
+BLEND_NONE = 0
+BLEND_ALPHA = 1
+BLEND_ADDITIVE = 2
+
+BACKEND_LEGACY = 0
+BACKEND_CORE = 1
+
+JOIN_MITER = 0
+JOIN_BEVEL = 1
+JOIN_ROUND = 2
+
+CAP_BUTT = 0
+CAP_SQUARE = 1
+CAP_ROUND = 2
+
+NEAREST = 0x2600
+LINEAR = 0x2601
+
+CLAMP_TO_EDGE = 0x812F
+REPEAT = 0x2901
+MIRRORED_REPEAT = 0x8370
+
 
 def color_to_float_values(color):
     if isinstance(color, str):
@@ -32,59 +71,159 @@ class Window(_graphics.Window):
 class Renderer(_graphics.Renderer):
     """Represents OpenGL 2D rendering context for a window."""
 
-    def __init__(self, window):
-        super().__init__(window)
+    def __init__(self, window, batching=False, backend=BACKEND_LEGACY):
+        super().__init__(window, backend)
         self.window = window
+        self.batching = batching
+        self.textures = TextureCache(self)
 
     def clear(self, color):
         """Clears the screen to specified color."""
         self._clear(*color_to_float_values(color))
 
-    def create_texture(self, image):
-        """Generates a texture from image."""
-        texture = Texture()
-        texture.id = self._generate_texture(image.pixels, image.width, image.height, image.components)
-        texture.width = image.width
-        texture.height = image.height
-        return texture
+    def create_texture(self, image, filter=NEAREST, wrap=CLAMP_TO_EDGE, mipmaps=False):
+        """Generates a texture from image, deleted once no longer referenced.
+
+        filter is NEAREST or LINEAR, wrap one of CLAMP_TO_EDGE, REPEAT or MIRRORED_REPEAT,
+        mipmaps keeps textures drawn scaled down smooth and cache friendly.
+        """
+        return Texture(self, image, filter, wrap, mipmaps)
+
+    def load_texture(self, image):
+        """Returns the texture of an image or image file path, uploading it only once per renderer."""
+        return self.textures.get(image)
+
+    def update_texture(self, texture, image, x=0, y=0):
+        """Uploads image into an existing texture at x, y, reallocating it only when the image doesn't fit.
+
+        An image at the origin replaces what the texture shows, others only extend it.
+        """
+        texture._update(image.pixels, image.width, image.height, image.components, x, y)
+
+    def create_atlas(self, width=1024, height=1024, padding=1):
+        """Creates an atlas that packs many images into a few shared textures."""
+        return Atlas(self, width, height, padding)
+
+    def create_mesh(self, coordinates):
+        """Uploads coordinates (x0, y0, x1, y1 ...) to the GPU once for repeated drawing."""
+        return Mesh(self, coordinates)
+
+    def draw_mesh(self, mesh, mode=POLYGON, width=1.0, smooth=False):
+        """Draws a mesh created by this renderer as the given primitive (POLYGON, LINE_LOOP ...).
+
+        Smooth LINE_LOOP and LINE_STRIP outlines are anti-aliased like
+        draw_line_loop and batch with other draws.
+        """
+        self._draw_mesh(mesh, mode, width, smooth)
+
+    def draw_instances(self, mesh, transforms, mode=POLYGON, width=1.0, smooth=False):
+        """Draws a mesh once per packed (x, y, angle, scale, r, g, b, a) transform in a single call."""
+        self._draw_instances(mesh, transforms, mode, width, smooth)
+
+    def begin_recording(self, commands=None):
+        """Collects the following draws into a CommandList instead of drawing them.
+
+        Recording starts from an identity transform and the commands list,
+        if given, is cleared for reuse.
+        """
+        self._begin_recording(CommandList() if commands is None else commands)
+
+    def replay(self, commands, transform=(0.0, 0.0, 0.0, 1.0)):
+        """Draws a CommandList from end_recording(), moved by an (x, y, angle, scale) transform.
+
+        The transform applies on top of the current one, and the recorded
+        vertices are only copied into the batch, so static scenery costs no
+        Python calls per shape. The list keeps the textures it draws alive and
+        only replays into the renderer that recorded it.
+        """
+        x, y, angle, scale = transform
+        self._replay(commands, x, y, angle, scale)
+
+    def draw_line_loop(self, coordinates, width=1.0, smooth=False, join=None):
+        """Draws a closed outline, joined with JOIN_MITER, JOIN_BEVEL or JOIN_ROUND.
+
+        Lines wider than a pixel, smooth, or with a join given, are drawn as
+        triangles that batch together with fills. Smooth lines fade out over
+        a pixel wide edge instead of relying on GL_LINE_SMOOTH.
+        """
+        self._draw_line_loop(coordinates, width, smooth, -1 if join is None else join)
+
+    def draw_line_strip(self, coordinates, width=1.0, smooth=False, join=None, cap=None):
+        """Draws an open line, joined like draw_line_loop and ended with CAP_BUTT, CAP_SQUARE or CAP_ROUND."""
+        self._draw_line_strip(
+            coordinates, width, smooth,
+            -1 if join is None else join,
+            -1 if cap is None else cap
+        )
 
-    def draw_line_loop(self, coordinates, width=1.0, smooth=False):
-        coordinates = coordinates + coordinates[:2]
-        self.draw_line_strip(coordinates, width, smooth)
+    def draw_line_loops(self, coordinates, offsets, width=1.0, smooth=False, join=None):
+        """Draws many closed outlines from packed points (x0, y0, x1, y1 ...) in one call.
 
-    def draw_line_strip(self, coordinates, width=1.0, smooth=False):
-        if len(coordinates) % 2 != 0:
-            raise ValueError('coordinates must be a sequence of float values (x0, y0, x1, y1 ...)')
-        self._draw_line_strip(coordinates, width, smooth)
+        offsets holds the index of the first point of every loop, each one
+        ending where the next starts.
+        """
+        self._draw_line_loops(coordinates, offsets, width, smooth, -1 if join is None else join)
 
     def draw_rectangle(self, top, left, width, height, fill=True):
-        coordinates = (
-            left, top,
-            left, top + height,
-            left + width, top + height,
-            left + width, top
-        )
-        self.draw_polygon(coordinates)
+        self._draw_rectangles((left, top, width, height), fill, 1.0, False)
+
+    def draw_rectangles(self, rectangles, fill=True, width=1.0, smooth=False):
+        """Draws many rectangles from packed (x, y, width, height) values in one call."""
+        self._draw_rectangles(rectangles, fill, width, smooth)
+
+    def draw_circle(self, x, y, radius, fill=True, width=1.0, smooth=False, segments=None):
+        self._draw_circles((x, y, radius), fill, width, smooth, segments or 0)
+
+    def draw_circles(self, circles, fill=True, width=1.0, smooth=False, segments=None):
+        """Draws many circles from packed (x, y, radius) values in one call.
+
+        Without a number of segments, each circle gets enough to stay within
+        a quarter pixel of its radius.
+        """
+        self._draw_circles(circles, fill, width, smooth, segments or 0)
+
+    def draw_texture_region(self, region, x=0, y=0, width=None, height=None):
+        """Draws an atlas region at the given position, optionally scaled to width and height."""
+        if width is None:
+            width = region.width
+        if height is None:
+            height = region.height
+        self._draw_texture_region(region.atlas, region.texture, *region.uv, x, y, width, height)
+
+    def draw_text(self, font, text, x=0, y=0, color=None):
+        """Draws text with its top left corner at x, y, in the current color unless one is given.
+
+        Glyphs are packed into a texture atlas of the font the first time
+        they are drawn, so changing text only costs a quad per glyph.
+        """
+        if color is None:
+            self._draw_text(font, text, x, y)
+        else:
+            self._draw_text(font, text, x, y, color_to_float_values(color))
 
     def draw_polygon(self, coordinates):
-        if len(coordinates) % 2 != 0:
-            raise ValueError('coordinates must be a sequence of float values (x0, y0, x1, y1 ...)')
+        """Draws a simple polygon, convex or not, from a sequence or buffer (array, memoryview ...) of x, y values."""
         self._draw_polygon(coordinates)
 
     def draw_texture(self, texture):
+        u, v = texture.factor
         coordinates = (
             0, 0,
-            0 + texture.width, 0,
-            0 + texture.width, 0 + texture.height,
-            0, 0 + texture.height
+            0 + texture.image_width, 0,
+            0 + texture.image_width, 0 + texture.image_height,
+            0, 0 + texture.image_height
         )
         texture_coordinates = (
             0, 0,
-            1, 0,
-            1, 1,
-            0, 1
+            u, 0,
+            u, v,
+            0, v
         )
-        self._draw_textured_polygon(coordinates, texture_coordinates, texture.id)
+        self._draw_textured_polygon(coordinates, texture_coordinates, texture)
+
+    def set_blend_mode(self, mode):
+        """Selects how drawn pixels are combined with the screen (BLEND_NONE, BLEND_ALPHA, BLEND_ADDITIVE)."""
+        self._set_blend_mode(mode)
 
     def set_color(self, color):
         self._set_color(*color_to_float_values(color))
@@ -98,27 +237,95 @@ class Renderer(_graphics.Renderer):
 
     def present(self):
         """Returns result of drawing operations as Image."""
-        pixels = self._read_pixels(self.window.width, self.window.height)
-        return Image(pixels, self.window.width, self.window.height, 3)
+        pixels = self._read_pixels(self.width, self.height)
+        return Image(pixels, self.width, self.height, 3)
+
+    def poll_capture(self, wait=False):
+        """Returns the oldest frame from request_capture() as Image, or None while it is still being copied."""
+        capture = self._poll_capture(wait)
+        if capture is None:
+            return None
+        pixels, width, height = capture
+        return Image(pixels, width, height, 3)
+
+
+class OffscreenRenderer(Renderer, _graphics.OffscreenRenderer):
+    """Represents OpenGL 2D rendering context drawing into an image, without any window or display."""
+
+    def __init__(self, width, height, batching=False, backend=BACKEND_LEGACY):
+        _graphics.OffscreenRenderer.__init__(self, width, height, backend)
+        self.window = None
+        self.batching = batching
+        self.textures = TextureCache(self)
+
+
+class CommandList(_graphics.CommandList):
+    """Draws recorded between Renderer.begin_recording() and end_recording(), replayed with Renderer.replay()."""
+
+
+class Atlas(_graphics.Atlas):
+    """Packs many images into a few large textures of a rendering context."""
+
+    def __init__(self, renderer, width=1024, height=1024, padding=1):
+        super().__init__(renderer, width, height, padding)
+        self.renderer = renderer
+
+    def add(self, image):
+        """Packs an image into the atlas and returns its region."""
+        texture, x, y, width, height = self._add(image.pixels, image.width, image.height, image.components)
+        return AtlasRegion(self, texture, x, y, width, height)
+
+
+class AtlasRegion:
+    """Represents an image packed into an atlas texture."""
+
+    def __init__(self, atlas, texture, x, y, width, height):
+        self.atlas = atlas
+        self.texture = texture
+        self.x = x
+        self.y = y
+        self.width = width
+        self.height = height
+        self.uv = (
+            x / atlas.width,
+            y / atlas.height,
+            (x + width) / atlas.width,
+            (y + height) / atlas.height
+        )
+
+
+class Mesh(_graphics.Mesh):
+    """Represents vertex coordinates stored in a GPU buffer of a rendering context."""
+
+    def __init__(self, renderer, coordinates):
+        super().__init__(renderer, coordinates)
+        self.renderer = renderer
 
 
 class Font(_graphics.Font):
     """The Font class specifies a font used for drawing text."""
 
-    def render_text(self, text):
-        image_attributes = super().render_text(text)
-        return Image(*image_attributes)
+    def render_text(self, text, components=4, tight=False, buffer=None):
+        """Rasterizes text into an Image.
+
+        components=4 gives white RGBA pixels with the glyph coverage as alpha,
+        components=1 the coverage alone, which textures tint with the draw
+        color at a quarter of the memory. The image is padded to power of two
+        sizes unless tight, and pixels go into buffer when one is given.
+        """
+        image_attributes = super().render_text(text, components, tight, buffer)
+        return Image(*image_attributes, coverage=components == 1)
 
 
-class Texture:
+class Texture(_graphics.Texture):
     """Represents OpenGL texture generated from context."""
 
-    def __init__(self):
-        self.id = 0
-        self.width = 0
-        self.height = 0
-        self.image_width = 0
-        self.image_height = 0
+    def __init__(self, renderer, image, filter=NEAREST, wrap=CLAMP_TO_EDGE, mipmaps=False):
+        super().__init__(
+            renderer, image.pixels, image.width, image.height, image.components,
+            filter, wrap, mipmaps, image.coverage
+        )
+        self.renderer = renderer
 
     @property
     def factor(self):
@@ -126,15 +333,85 @@ class Texture:
         return self.image_width / self.width, self.image_height / self.height
 
 
+class TextureCache:
+    """Keeps the textures of a renderer, so every image is uploaded once.
+
+    Images loaded from files are looked up by source path, others by identity.
+    Least recently used textures are dropped once the cache holds more than
+    capacity bytes, and deleted as soon as nothing else refers to them.
+    """
+
+    def __init__(self, renderer, capacity=64 * 1024 * 1024):
+        self.renderer = renderer
+        self.capacity = capacity
+        self.size = 0
+        self._entries = collections.OrderedDict()
+
+    def __len__(self):
+        return len(self._entries)
+
+    def __contains__(self, image):
+        return self._key(image) in self._entries
+
+    def _key(self, image):
+        if isinstance(image, str):
+            return image
+        if image.source:
+            return image.source
+        return id(image)
+
+    def get(self, image):
+        """Returns the texture of an image or image file path, creating it on first use."""
+        key = self._key(image)
+        entry = self._entries.get(key)
+        if entry is not None:
+            self._entries.move_to_end(key)
+            return entry[0]
+        if isinstance(image, str):
+            image = Image.load(image)
+        texture = self.renderer.create_texture(image)
+        reference = None
+        if isinstance(key, int):
+            # identities are reused once an image is gone
+            reference = weakref.ref(image, lambda _: self._remove(key))
+        size = texture.width * texture.height * texture.components
+        if texture.mipmaps:
+            size += size // 3
+        self._entries[key] = (texture, reference, size)
+        self.size += size
+        while self.size > self.capacity and len(self._entries) > 1:
+            self._remove(next(iter(self._entries)))
+        return texture
+
+    def discard(self, image):
+        """Drops the texture of an image or image file path if cached."""
+        self._remove(self._key(image))
+
+    def clear(self):
+        """Drops all textures."""
+        self._entries.clear()
+        self.size = 0
+
+    def _remove(self, key):
+        entry = self._entries.pop(key, None)
+        if entry is not None:
+            self.size -= entry[2]
+
+
 class Image:
-    """Represents context-independent image object that allows direct access to the pixel data."""
+    """Represents context-independent image object that allows direct access to the pixel data.
+
+    Single component images are grey, unless coverage marks them as glyph
+    coverage that textures draw as white tinted by the draw color.
+    """
 
-    def __init__(self, pixels, width, height, components, source=''):
+    def __init__(self, pixels, width, height, components, source='', coverage=False):
         self._pixels = pixels
         self._width = width
         self._height = height
         self._components = components
         self.source = source
+        self.coverage = coverage
         self.texture = 0
 
     @property